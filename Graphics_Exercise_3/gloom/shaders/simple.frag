@@ -6,24 +6,83 @@ layout(location = 2) in vec3 in_normal;
 
 layout(location = 0) out vec4 out_fragColor;
 
-uniform layout(location = 1) mat4 u_modelTransformationMatrix;
+// Size of the cluster grid (LIGHT_CLUSTERS_X, _Y and _Z in lightClusters.hpp)
+const uint clustersX = 16;
+const uint clustersY = 9;
+const uint clustersZ = 24;
+
+// Point lights (see PointLight in lightClusters.hpp)
+struct PointLight
+{
+	vec4 positionRadius;
+	vec4 color;
+};
+
+layout(std430, binding = 1) readonly buffer LightBuffer
+{
+	PointLight lights[];
+};
+
+// Offset and count of the light indices of every cluster, and the light indices
+layout(std430, binding = 2) readonly buffer ClusterBuffer
+{
+	uvec2 clusters[];
+};
+
+layout(std430, binding = 3) readonly buffer LightIndexBuffer
+{
+	uint lightIndices[];
+};
+
+uniform layout(location = 1) mat4 u_viewMatrix;
+
+// Clusters per pixel (xy), and the slice of a depth: slice = log2(depth) * z + w
+uniform layout(location = 2) vec4 u_clusterParameters;
+
+// Number of lights, and whether to loop over every light instead of the lights of the fragment's cluster
+uniform layout(location = 3) uint u_lightCount;
+uniform layout(location = 4) bool u_allLights;
+
+// Diffuse light from one point light, which fades out smoothly and reaches zero at its radius
+vec3 shadePointLight(PointLight light, vec3 position, vec3 normal)
+{
+	vec3 toLight = light.positionRadius.xyz - position;
+	float distance = length(toLight);
+	float falloff = clamp(1.0 - pow(distance / light.positionRadius.w, 4.0), 0.0, 1.0);
+	float brightness = clamp(dot(normal, toLight) / distance, 0.0, 1.0);
+	return falloff * falloff * brightness * light.color.rgb;
+}
 
 void main()
 {
-    // Convert the normal for this fragment into world space
-    mat3 normalMatrix = transpose(inverse(mat3(u_modelTransformationMatrix)));
-    vec3 normal = normalize(normalMatrix * in_normal);
-    
-    // Calculate the position of this fragment in world space
-    vec3 fragPosition = (u_modelTransformationMatrix * vec4(in_position, 1.0)).rgb;
-
-    // Calculate the cosine of the angle of incidence
-    float brightness = dot(normal, -fragPosition) / (length(fragPosition) * length(normal));
-    brightness = clamp(brightness, 0.0, 1.0);
-
-	// Make the sun bright by setting brightness to 1 if world position is less than 1 (radius of sun)
-	brightness = mix(brightness, 1.0, length(fragPosition) <= 1.0);
-
-    // Calculate out color using brightness
-    out_fragColor = vec4(max(brightness, 0.1) * in_color.rgb, 1.0f);
-}
\ No newline at end of file
+    // The position and normal are already in world space
+    vec3 normal = normalize(in_normal);
+    vec3 fragPosition = in_position;
+
+	vec3 light = vec3(0.0);
+	if(u_allLights)
+	{
+		for(uint i = 0; i < u_lightCount; i++)
+		{
+			light += shadePointLight(lights[i], fragPosition, normal);
+		}
+	}
+	else
+	{
+		// Find the fragment's cluster, and only shade the lights that reach it
+		float depth = -(u_viewMatrix * vec4(fragPosition, 1.0)).z;
+		uvec2 tile = min(uvec2(gl_FragCoord.xy * u_clusterParameters.xy), uvec2(clustersX - 1, clustersY - 1));
+		uint slice = uint(clamp(floor(log2(depth) * u_clusterParameters.z + u_clusterParameters.w), 0.0, float(clustersZ - 1)));
+		uvec2 cluster = clusters[(slice * clustersY + tile.y) * clustersX + tile.x];
+		for(uint i = 0; i < cluster.y; i++)
+		{
+			light += shadePointLight(lights[lightIndices[cluster.x + i]], fragPosition, normal);
+		}
+	}
+
+	// Make the sun bright by setting the light to 1 if world position is less than 1 (radius of sun)
+	if(length(fragPosition) <= 1.0) light = vec3(1.0);
+
+    // Calculate out color using the light, with some ambient light
+    out_fragColor = vec4(max(light, vec3(0.1)) * in_color.rgb, 1.0f);
+}
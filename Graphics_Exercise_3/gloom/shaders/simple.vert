@@ -2,18 +2,35 @@
 
 layout(location = 0) in vec3 in_vertexPosition;
 layout(location = 1) in vec4 in_vertexColor;
+layout(location = 2) in vec3 in_vertexNormal;
 
 layout(location = 0) out vec3 out_position;
 layout(location = 1) out vec4 out_color;
 layout(location = 2) out vec3 out_normal;
 
-uniform layout(location = 0) mat4 u_transformationMatrix;
+// Per instance data, computed on the CPU once per node (see SceneInstance in program.cpp)
+struct Instance
+{
+	mat4 modelViewProjection;
+	mat4 model;
+	mat3 normalMatrix;
+};
+
+layout(std430, binding = 0) readonly buffer InstanceBuffer
+{
+	Instance instances[];
+};
+
+// Index of the first instance of this draw
+uniform layout(location = 0) uint u_firstInstance;
 
 void main()
 {
-    gl_Position = u_transformationMatrix * vec4(in_vertexPosition, 1.0f);
-	
-	out_position = in_vertexPosition;
+	Instance instance = instances[u_firstInstance + gl_InstanceID];
+	gl_Position = instance.modelViewProjection * vec4(in_vertexPosition, 1.0f);
+
+	// Lighting inputs in world space
+	out_position = (instance.model * vec4(in_vertexPosition, 1.0f)).xyz;
 	out_color = in_vertexColor;
-	out_normal = normalize(in_vertexPosition.xyz);
+	out_normal = instance.normalMatrix * in_vertexNormal;
 }
@@ -0,0 +1,220 @@
+#include "jobSystem.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A queued job together with its counter
+struct QueuedJob
+{
+	Job job;
+	JobCounter *counter;
+};
+
+// Job queue owned by one thread
+struct JobQueue
+{
+	std::mutex mutex;
+	std::deque<QueuedJob> jobs;
+};
+
+// Queue 0 belongs to the threads that aren't workers (i.e. the main thread), queue i belongs to worker i
+static std::vector<JobQueue*> queues;
+static std::vector<std::thread> workers;
+static std::atomic<bool> running(false);
+static std::atomic<int> queuedJobCount(0);
+
+// Sleeping workers wait on this until new jobs are queued
+static std::mutex wakeMutex;
+static std::condition_variable wakeCondition;
+
+// Index of the queue owned by the calling thread
+static thread_local unsigned int threadQueueIndex = 0;
+
+// Pops a job from the back of the calling thread's queue, or steals one from the front of another queue
+static bool takeJob(QueuedJob &job)
+{
+	const unsigned int queueCount = queues.size();
+	if(queueCount == 0) return false;
+
+	// Own queue first (most recently pushed job, which is likely to be warm in the cache)
+	{
+		JobQueue *queue = queues[threadQueueIndex];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if(!queue->jobs.empty())
+		{
+			job = queue->jobs.back();
+			queue->jobs.pop_back();
+			queuedJobCount--;
+			return true;
+		}
+	}
+
+	// Steal the oldest job of another queue, starting at the queue after ours
+	for(unsigned int i = 1; i < queueCount; i++)
+	{
+		JobQueue *queue = queues[(threadQueueIndex + i) % queueCount];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if(!queue->jobs.empty())
+		{
+			job = queue->jobs.front();
+			queue->jobs.pop_front();
+			queuedJobCount--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Runs a job and signals its counter
+static void runJob(QueuedJob &job)
+{
+	job.job();
+	if(job.counter) (*job.counter)--;
+}
+
+// Worker thread main loop
+static void workerLoop(const unsigned int queueIndex)
+{
+	threadQueueIndex = queueIndex;
+	while(true)
+	{
+		QueuedJob job;
+		if(takeJob(job))
+		{
+			runJob(job);
+			continue;
+		}
+
+		// Nothing to do; sleep until jobs are queued
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		if(!running && queuedJobCount == 0) break;
+		wakeCondition.wait(lock, []() { return queuedJobCount > 0 || !running; });
+	}
+}
+
+void initJobSystem(unsigned int workerCount)
+{
+	if(running) return;
+
+	if(workerCount == 0)
+	{
+		workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	running = true;
+	for(unsigned int i = 0; i <= workerCount; i++)
+	{
+		queues.push_back(new JobQueue);
+	}
+	for(unsigned int i = 1; i <= workerCount; i++)
+	{
+		workers.push_back(std::thread(workerLoop, i));
+	}
+}
+
+void shutdownJobSystem()
+{
+	if(!running) return;
+
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		running = false;
+	}
+	wakeCondition.notify_all();
+	for(std::thread &worker : workers)
+	{
+		worker.join();
+	}
+	workers.clear();
+
+	// Run whatever is left (only possible if there were no workers)
+	QueuedJob job;
+	while(takeJob(job))
+	{
+		runJob(job);
+	}
+
+	for(JobQueue *queue : queues)
+	{
+		delete queue;
+	}
+	queues.clear();
+}
+
+unsigned int getJobThreadCount()
+{
+	return workers.size() + 1;
+}
+
+void submitJob(const Job &job, JobCounter *counter)
+{
+	if(counter) (*counter)++;
+
+	// Without a job system, run the job right away
+	if(queues.empty())
+	{
+		job();
+		if(counter) (*counter)--;
+		return;
+	}
+
+	QueuedJob queuedJob;
+	queuedJob.job = job;
+	queuedJob.counter = counter;
+	{
+		JobQueue *queue = queues[threadQueueIndex];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->jobs.push_back(queuedJob);
+		queuedJobCount++;
+	}
+
+	// Wake a sleeping worker. Taking the wake mutex first makes sure a worker that just found nothing to do is either
+	// already waiting (and gets the notification) or hasn't checked queuedJobCount yet (and sees the new job).
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+	}
+	wakeCondition.notify_one();
+}
+
+void waitForCounter(JobCounter *counter)
+{
+	// Help out with the queued jobs instead of blocking
+	while(*counter > 0)
+	{
+		QueuedJob job;
+		if(takeJob(job))
+		{
+			runJob(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void parallelFor(const unsigned int count, const unsigned int grainSize, const std::function<void(unsigned int, unsigned int)> &function)
+{
+	// Small ranges aren't worth the overhead of queueing
+	if(count <= grainSize || queues.empty())
+	{
+		if(count > 0) function(0, count);
+		return;
+	}
+
+	JobCounter counter(0);
+	for(unsigned int begin = grainSize; begin < count; begin += grainSize)
+	{
+		const unsigned int end = std::min(begin + grainSize, count);
+		submitJob([&function, begin, end]() { function(begin, end); }, &counter);
+	}
+
+	// Run the first range on this thread, then help with the rest
+	function(0, grainSize);
+	waitForCounter(&counter);
+}
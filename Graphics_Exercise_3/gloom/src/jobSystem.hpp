@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+// Work-stealing job system. Every worker thread owns a job queue: it pushes and pops jobs at the back of
+// its own queue, and steals jobs from the front of the other queues when its own queue is empty.
+// Jobs must not call OpenGL, the GL context belongs to the main thread.
+
+// A job, and the counter that tracks a group of jobs (it is decremented when a job in the group finishes)
+typedef std::function<void()> Job;
+typedef std::atomic<int> JobCounter;
+
+// Starts 'workerCount' worker threads (0 = one less than the number of hardware threads)
+void initJobSystem(unsigned int workerCount = 0);
+
+// Finishes the queued jobs and stops the worker threads
+void shutdownJobSystem();
+
+// Returns the number of threads that run jobs (the workers and the thread that waits for them)
+unsigned int getJobThreadCount();
+
+// Queues 'job' and increments 'counter' (if given) until the job has finished
+void submitJob(const Job &job, JobCounter *counter);
+
+// Runs queued jobs on the calling thread until 'counter' reaches zero
+void waitForCounter(JobCounter *counter);
+
+// Calls 'function' on the ranges [begin, end) of [0, count), in parallel, with at most 'grainSize' elements per range.
+// Returns when all ranges are done.
+void parallelFor(const unsigned int count, const unsigned int grainSize, const std::function<void(unsigned int, unsigned int)> &function);
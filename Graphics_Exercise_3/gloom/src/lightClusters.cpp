@@ -0,0 +1,252 @@
+#include "lightClusters.hpp"
+#include "jobSystem.hpp"
+
+#include <cstring>
+
+// Number of lights per cluster range job
+#define LIGHT_CLUSTERS_JOB_SIZE 1024
+
+// Screen tiles per slice
+#define LIGHT_CLUSTER_TILE_COUNT (LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y)
+
+LightClusterGrid createLightClusterGrid(const float fovY, const float aspect, const float nearPlane, const float farPlane)
+{
+	LightClusterGrid grid;
+	grid.tanHalfFovY = tanf(fovY * 0.5f);
+	grid.tanHalfFovX = grid.tanHalfFovY * aspect;
+	grid.nearPlane = nearPlane;
+	grid.farPlane = farPlane;
+
+	// Slice i covers the depths [near * (far / near)^(i / slices), near * (far / near)^((i + 1) / slices))
+	grid.sliceScale = LIGHT_CLUSTERS_Z / log2f(farPlane / nearPlane);
+	grid.sliceBias = -log2f(nearPlane) * grid.sliceScale;
+
+	grid.clusters.resize(LIGHT_CLUSTER_COUNT);
+	grid.sliceIndices.resize(LIGHT_CLUSTERS_Z);
+	return grid;
+}
+
+// Finds the screen tiles that the light 'i' covers, and its view space depth. The light's sphere spans the depths
+// [depth - radius, depth + radius], and its projected extent along an axis is largest at the near end of that range
+// when the extent is on the far side of the view direction, and at the far end otherwise.
+static inline void computeLightTiles(LightClusterGrid &grid, const PointLight &light, const glm::mat4 &viewMatrix, const unsigned int i)
+{
+	const glm::vec3 position = glm::vec3(viewMatrix * glm::vec4(glm::vec3(light.positionRadius), 1.0f));
+	const float radius = light.positionRadius.w;
+	const float depth = -position.z;
+	const float nearDepth = glm::max(depth - radius, grid.nearPlane);
+	const float farDepth = depth + radius;
+
+	const float xMin = position.x - radius, xMax = position.x + radius;
+	const float yMin = position.y - radius, yMax = position.y + radius;
+	const float tileXMin = (xMin / ((xMin < 0.0f ? nearDepth : farDepth) * grid.tanHalfFovX) * 0.5f + 0.5f) * LIGHT_CLUSTERS_X;
+	const float tileXMax = (xMax / ((xMax > 0.0f ? nearDepth : farDepth) * grid.tanHalfFovX) * 0.5f + 0.5f) * LIGHT_CLUSTERS_X;
+	const float tileYMin = (yMin / ((yMin < 0.0f ? nearDepth : farDepth) * grid.tanHalfFovY) * 0.5f + 0.5f) * LIGHT_CLUSTERS_Y;
+	const float tileYMax = (yMax / ((yMax > 0.0f ? nearDepth : farDepth) * grid.tanHalfFovY) * 0.5f + 0.5f) * LIGHT_CLUSTERS_Y;
+
+	grid.depth[i] = depth;
+	if(tileXMax < 0.0f || tileXMin > LIGHT_CLUSTERS_X || tileYMax < 0.0f || tileYMin > LIGHT_CLUSTERS_Y)
+	{
+		// Outside the frustum's sides
+		grid.minX[i] = LIGHT_CLUSTERS_X;
+		grid.maxX[i] = 0;
+		return;
+	}
+	grid.minX[i] = (int) glm::clamp(tileXMin, 0.0f, LIGHT_CLUSTERS_X - 1.0f);
+	grid.maxX[i] = (int) glm::clamp(tileXMax, 0.0f, LIGHT_CLUSTERS_X - 1.0f);
+	grid.minY[i] = (int) glm::clamp(tileYMin, 0.0f, LIGHT_CLUSTERS_Y - 1.0f);
+	grid.maxY[i] = (int) glm::clamp(tileYMax, 0.0f, LIGHT_CLUSTERS_Y - 1.0f);
+}
+
+#ifdef LIGHT_CLUSTERS_SSE
+// Returns mask ? a : b
+static inline __m128 select4(const __m128 mask, const __m128 a, const __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Converts window coordinates along an axis to tiles (clamped to [0, tiles - 1]) and stores them
+static inline void storeTiles4(const __m128 tiles, const __m128 maxTile, int32_t *destination)
+{
+	const __m128 clamped = _mm_min_ps(_mm_max_ps(tiles, _mm_setzero_ps()), maxTile);
+	_mm_storeu_si128((__m128i*) destination, _mm_cvttps_epi32(clamped));
+}
+
+// computeLightTiles() for the 4 lights starting at 'first'
+static inline void computeLightTiles4(LightClusterGrid &grid, const PointLight *lights, const glm::mat4 &viewMatrix, const unsigned int first)
+{
+	// Transpose the positions and radii of the 4 lights
+	__m128 px = _mm_loadu_ps(&lights[first].positionRadius.x);
+	__m128 py = _mm_loadu_ps(&lights[first + 1].positionRadius.x);
+	__m128 pz = _mm_loadu_ps(&lights[first + 2].positionRadius.x);
+	__m128 radius = _mm_loadu_ps(&lights[first + 3].positionRadius.x);
+	_MM_TRANSPOSE4_PS(px, py, pz, radius);
+
+	// View space position (viewMatrix[column][row])
+	const __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(viewMatrix[0][0]), px), _mm_mul_ps(_mm_set1_ps(viewMatrix[1][0]), py)),
+	                            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(viewMatrix[2][0]), pz), _mm_set1_ps(viewMatrix[3][0])));
+	const __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(viewMatrix[0][1]), px), _mm_mul_ps(_mm_set1_ps(viewMatrix[1][1]), py)),
+	                            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(viewMatrix[2][1]), pz), _mm_set1_ps(viewMatrix[3][1])));
+	const __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(viewMatrix[0][2]), px), _mm_mul_ps(_mm_set1_ps(viewMatrix[1][2]), py)),
+	                            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(viewMatrix[2][2]), pz), _mm_set1_ps(viewMatrix[3][2])));
+	const __m128 depth = _mm_sub_ps(_mm_setzero_ps(), z);
+	const __m128 nearDepth = _mm_max_ps(_mm_sub_ps(depth, radius), _mm_set1_ps(grid.nearPlane));
+	const __m128 farDepth = _mm_add_ps(depth, radius);
+	_mm_storeu_ps(&grid.depth[first], depth);
+
+	// Projected extent in tiles
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 scaleX = _mm_set1_ps(grid.tanHalfFovX), scaleY = _mm_set1_ps(grid.tanHalfFovY);
+	const __m128 tilesX = _mm_set1_ps((float) LIGHT_CLUSTERS_X), tilesY = _mm_set1_ps((float) LIGHT_CLUSTERS_Y);
+	const __m128 xMin = _mm_sub_ps(x, radius), xMax = _mm_add_ps(x, radius);
+	const __m128 yMin = _mm_sub_ps(y, radius), yMax = _mm_add_ps(y, radius);
+	const __m128 tileXMin = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_div_ps(xMin, _mm_mul_ps(select4(_mm_cmplt_ps(xMin, zero), nearDepth, farDepth), scaleX)), half), half), tilesX);
+	const __m128 tileXMax = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_div_ps(xMax, _mm_mul_ps(select4(_mm_cmpgt_ps(xMax, zero), nearDepth, farDepth), scaleX)), half), half), tilesX);
+	const __m128 tileYMin = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_div_ps(yMin, _mm_mul_ps(select4(_mm_cmplt_ps(yMin, zero), nearDepth, farDepth), scaleY)), half), half), tilesY);
+	const __m128 tileYMax = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_div_ps(yMax, _mm_mul_ps(select4(_mm_cmpgt_ps(yMax, zero), nearDepth, farDepth), scaleY)), half), half), tilesY);
+
+	storeTiles4(tileXMin, _mm_set1_ps(LIGHT_CLUSTERS_X - 1.0f), &grid.minX[first]);
+	storeTiles4(tileXMax, _mm_set1_ps(LIGHT_CLUSTERS_X - 1.0f), &grid.maxX[first]);
+	storeTiles4(tileYMin, _mm_set1_ps(LIGHT_CLUSTERS_Y - 1.0f), &grid.minY[first]);
+	storeTiles4(tileYMax, _mm_set1_ps(LIGHT_CLUSTERS_Y - 1.0f), &grid.maxY[first]);
+
+	// Lights outside the frustum's sides get an empty x range
+	const __m128 outside = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(tileXMax, zero), _mm_cmpgt_ps(tileXMin, tilesX)),
+	                                 _mm_or_ps(_mm_cmplt_ps(tileYMax, zero), _mm_cmpgt_ps(tileYMin, tilesY)));
+	const int outsideMask = _mm_movemask_ps(outside);
+	for(int lane = 0; lane < 4; lane++)
+	{
+		if(outsideMask & (1 << lane))
+		{
+			grid.minX[first + lane] = LIGHT_CLUSTERS_X;
+			grid.maxX[first + lane] = 0;
+		}
+	}
+}
+#endif
+
+// Finds the slices that the light 'i' covers, or an empty range if the light is culled
+static inline void computeLightSlices(LightClusterGrid &grid, const PointLight &light, const unsigned int i)
+{
+	const float radius = light.positionRadius.w;
+	const float depth = grid.depth[i];
+	if(grid.minX[i] > grid.maxX[i] || depth + radius < grid.nearPlane || depth - radius > grid.farPlane)
+	{
+		grid.minZ[i] = 1;
+		grid.maxZ[i] = 0;
+		return;
+	}
+	grid.minZ[i] = getLightClusterSlice(grid, glm::max(depth - radius, grid.nearPlane));
+	grid.maxZ[i] = getLightClusterSlice(grid, glm::min(depth + radius, grid.farPlane));
+}
+
+// Builds the light lists of the clusters of one slice, with offsets relative to the slice's first index
+static void buildSlice(LightClusterGrid &grid, const unsigned int count, const int slice)
+{
+	glm::uvec2 *clusters = &grid.clusters[slice * LIGHT_CLUSTER_TILE_COUNT];
+	for(int tile = 0; tile < LIGHT_CLUSTER_TILE_COUNT; tile++)
+	{
+		clusters[tile] = glm::uvec2(0);
+	}
+
+	// Count the lights of every cluster
+	const int32_t *minX = grid.minX.data(), *maxX = grid.maxX.data(), *minY = grid.minY.data(), *maxY = grid.maxY.data();
+	const int32_t *minZ = grid.minZ.data(), *maxZ = grid.maxZ.data();
+	for(unsigned int i = 0; i < count; i++)
+	{
+		if(slice < minZ[i] || slice > maxZ[i]) continue;
+		for(int y = minY[i]; y <= maxY[i]; y++)
+		{
+			for(int x = minX[i]; x <= maxX[i]; x++)
+			{
+				clusters[y * LIGHT_CLUSTERS_X + x].y++;
+			}
+		}
+	}
+
+	// Offsets, then fill in the indices in light order
+	uint32_t total = 0;
+	for(int tile = 0; tile < LIGHT_CLUSTER_TILE_COUNT; tile++)
+	{
+		clusters[tile].x = total;
+		total += clusters[tile].y;
+		clusters[tile].y = 0;
+	}
+	std::vector<uint32_t> &indices = grid.sliceIndices[slice];
+	indices.resize(total);
+	for(unsigned int i = 0; i < count; i++)
+	{
+		if(slice < minZ[i] || slice > maxZ[i]) continue;
+		for(int y = minY[i]; y <= maxY[i]; y++)
+		{
+			for(int x = minX[i]; x <= maxX[i]; x++)
+			{
+				glm::uvec2 &cluster = clusters[y * LIGHT_CLUSTERS_X + x];
+				indices[cluster.x + cluster.y++] = i;
+			}
+		}
+	}
+}
+
+void buildLightClusters(LightClusterGrid &grid, const PointLight *lights, const unsigned int count, const glm::mat4 &viewMatrix)
+{
+	grid.minX.resize(count);
+	grid.maxX.resize(count);
+	grid.minY.resize(count);
+	grid.maxY.resize(count);
+	grid.minZ.resize(count);
+	grid.maxZ.resize(count);
+	grid.depth.resize(count);
+
+	// Cluster range of every light (job sizes are multiples of 4, so only the last job has a remainder)
+	parallelFor(count, LIGHT_CLUSTERS_JOB_SIZE, [&](const unsigned int begin, const unsigned int end)
+	{
+		unsigned int i = begin;
+	#ifdef LIGHT_CLUSTERS_SSE
+		for(; i + 4 <= end; i += 4)
+		{
+			computeLightTiles4(grid, lights, viewMatrix, i);
+		}
+	#endif
+		for(; i < end; i++)
+		{
+			computeLightTiles(grid, lights[i], viewMatrix, i);
+		}
+		for(i = begin; i < end; i++)
+		{
+			computeLightSlices(grid, lights[i], i);
+		}
+	});
+
+	// Light lists of every slice, every slice is written by one job only
+	parallelFor(LIGHT_CLUSTERS_Z, 1, [&](const unsigned int begin, const unsigned int end)
+	{
+		for(unsigned int slice = begin; slice < end; slice++)
+		{
+			buildSlice(grid, count, slice);
+		}
+	});
+
+	// Concatenate the slices
+	uint32_t sliceOffsets[LIGHT_CLUSTERS_Z];
+	uint32_t total = 0;
+	for(int slice = 0; slice < LIGHT_CLUSTERS_Z; slice++)
+	{
+		sliceOffsets[slice] = total;
+		total += grid.sliceIndices[slice].size();
+	}
+	grid.lightIndices.resize(total);
+	parallelFor(LIGHT_CLUSTERS_Z, 1, [&](const unsigned int begin, const unsigned int end)
+	{
+		for(unsigned int slice = begin; slice < end; slice++)
+		{
+			const std::vector<uint32_t> &indices = grid.sliceIndices[slice];
+			if(!indices.empty()) memcpy(&grid.lightIndices[sliceOffsets[slice]], indices.data(), indices.size() * sizeof(uint32_t));
+			for(int tile = 0; tile < LIGHT_CLUSTER_TILE_COUNT; tile++)
+			{
+				grid.clusters[slice * LIGHT_CLUSTER_TILE_COUNT + tile].x += sliceOffsets[slice];
+			}
+		}
+	});
+}
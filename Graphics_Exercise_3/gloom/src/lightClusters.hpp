@@ -0,0 +1,72 @@
+#pragma once
+
+#include "simdMath.hpp"
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+
+// Clustered forward lighting. The view frustum is split into a grid of clusters (froxels): screen tiles, times
+// depth slices that grow exponentially with the distance from the camera. Every frame, each point light is added
+// to the list of every cluster its sphere overlaps, so a fragment only loops over the lights of its own cluster
+// instead of every light in the scene. The grid is built on the CPU with the job system (see jobSystem.hpp),
+// so initJobSystem() must have been called, and it doesn't depend on the number of threads.
+
+// Use the SSE kernel when the target supports SSE2 (define LIGHT_CLUSTERS_SCALAR to force the scalar path)
+#if !defined(LIGHT_CLUSTERS_SCALAR) && defined(SIMD_MATH_SSE)
+	#define LIGHT_CLUSTERS_SSE 1
+#endif
+
+// Size of the cluster grid: screen tiles across, tiles up, and depth slices (the same constants are in simple.frag)
+#define LIGHT_CLUSTERS_X 16
+#define LIGHT_CLUSTERS_Y 9
+#define LIGHT_CLUSTERS_Z 24
+#define LIGHT_CLUSTER_COUNT (LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y * LIGHT_CLUSTERS_Z)
+
+// A point light (matches the light buffer in simple.frag, std430 layout). The light fades out smoothly
+// and reaches zero at 'radius'.
+struct PointLight
+{
+	glm::vec4 positionRadius; // World space position, and radius
+	glm::vec4 color; // Colour times intensity (w is unused)
+};
+
+// Light lists of the clusters, for one camera
+struct LightClusterGrid
+{
+	float tanHalfFovX, tanHalfFovY; // Tangent of half the field of view
+	float nearPlane, farPlane; // Depth range of the slices
+	float sliceScale, sliceBias; // slice = log2(depth) * sliceScale + sliceBias
+
+	// Offset and count of the light indices of every cluster (x fastest, then y, then the slice)
+	std::vector<glm::uvec2> clusters;
+	std::vector<uint32_t> lightIndices;
+
+	// Cluster range of every light ([min, max] tile in x and y, and slice), and the light indices of every slice.
+	// Kept between frames so they aren't reallocated.
+	std::vector<int32_t> minX, maxX, minY, maxY, minZ, maxZ;
+	std::vector<float> depth; // View space depth of every light
+	std::vector<std::vector<uint32_t> > sliceIndices;
+};
+
+// Creates a cluster grid for a perspective projection (like glm::perspective(fovY, aspect, nearPlane, farPlane))
+LightClusterGrid createLightClusterGrid(const float fovY, const float aspect, const float nearPlane, const float farPlane);
+
+// Rebuilds the light lists of the clusters for 'count' lights seen through 'viewMatrix'
+void buildLightClusters(LightClusterGrid &grid, const PointLight *lights, const unsigned int count, const glm::mat4 &viewMatrix);
+
+// Returns the slice of the view space 'depth' (the distance along the view direction), clamped to the grid
+inline int getLightClusterSlice(const LightClusterGrid &grid, const float depth)
+{
+	const int slice = (int) floorf(log2f(depth) * grid.sliceScale + grid.sliceBias);
+	return slice < 0 ? 0 : (slice >= LIGHT_CLUSTERS_Z ? LIGHT_CLUSTERS_Z - 1 : slice);
+}
+
+// Returns the index of the cluster at normalized window coordinates 'x', 'y' (in [0, 1]) and view space 'depth'
+inline unsigned int getLightClusterIndex(const LightClusterGrid &grid, const float x, const float y, const float depth)
+{
+	const int tileX = glm::clamp((int) (x * LIGHT_CLUSTERS_X), 0, LIGHT_CLUSTERS_X - 1);
+	const int tileY = glm::clamp((int) (y * LIGHT_CLUSTERS_Y), 0, LIGHT_CLUSTERS_Y - 1);
+	return (getLightClusterSlice(grid, depth) * LIGHT_CLUSTERS_Y + tileY) * LIGHT_CLUSTERS_X + tileX;
+}
@@ -1,6 +1,7 @@
 // Local headers
 #include "gloom/gloom.hpp"
 #include "program.hpp"
+#include "jobSystem.hpp"
 
 // System headers
 #include <glad/glad.h>
@@ -72,9 +73,15 @@ int main(int argc, char* argb[])
     // Initialise window using GLFW
     GLFWwindow* window = initialise();
 
+    // Start the worker threads
+    initJobSystem();
+
     // Run an OpenGL application using this window
     runProgram(window);
 
+    // Stop the worker threads
+    shutdownJobSystem();
+
     // Terminate GLFW (no need to call glfwDestroyWindow)
     glfwTerminate();
 
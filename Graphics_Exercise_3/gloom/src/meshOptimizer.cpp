@@ -0,0 +1,313 @@
+#include "meshOptimizer.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+// Merges bit-identical vertices and rewrites the index buffer to reference the merged vertices
+unsigned int weldVertices(std::vector<float> &vertexData, const unsigned int stride, std::vector<unsigned int> &indices)
+{
+	const unsigned int vertexCount = vertexData.size() / stride;
+
+	// Sort the vertex indices by their contents, using the index as a tie-breaker so that
+	// the first vertex in a group of equal vertices is the one with the lowest index
+	std::vector<unsigned int> order(vertexCount);
+	for(unsigned int i = 0; i < vertexCount; i++) order[i] = i;
+	std::sort(order.begin(), order.end(), [&](const unsigned int a, const unsigned int b)
+	{
+		const int cmp = memcmp(&vertexData[a * stride], &vertexData[b * stride], stride * sizeof(float));
+		return cmp < 0 || (cmp == 0 && a < b);
+	});
+
+	// Map every vertex to the first vertex with the same contents
+	std::vector<unsigned int> remap(vertexCount);
+	for(unsigned int i = 0; i < vertexCount; i++)
+	{
+		if(i > 0 && memcmp(&vertexData[order[i] * stride], &vertexData[order[i - 1] * stride], stride * sizeof(float)) == 0)
+		{
+			remap[order[i]] = remap[order[i - 1]];
+		}
+		else
+		{
+			remap[order[i]] = order[i];
+		}
+	}
+
+	// Compact the vertex buffer, keeping the original order of the unique vertices
+	std::vector<unsigned int> newIndex(vertexCount);
+	unsigned int uniqueCount = 0;
+	for(unsigned int v = 0; v < vertexCount; v++)
+	{
+		if(remap[v] == v)
+		{
+			if(uniqueCount != v)
+			{
+				memmove(&vertexData[uniqueCount * stride], &vertexData[v * stride], stride * sizeof(float));
+			}
+			newIndex[v] = uniqueCount++;
+		}
+	}
+	vertexData.resize(uniqueCount * stride);
+
+	// Rewrite the index buffer
+	for(unsigned int &index : indices)
+	{
+		index = newIndex[remap[index]];
+	}
+
+	return uniqueCount;
+}
+
+// Simulates a FIFO cache of 'cacheSize' entries and returns the average number of cache misses per triangle
+float computeACMR(const std::vector<unsigned int> &indices, const unsigned int vertexCount, const unsigned int cacheSize)
+{
+	if(indices.size() < 3) return 0.0f;
+
+	// A vertex is in the cache if it was inserted less than 'cacheSize' insertions ago
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	unsigned int time = cacheSize + 1;
+	unsigned int misses = 0;
+	for(const unsigned int v : indices)
+	{
+		if(time - cacheTime[v] > cacheSize)
+		{
+			cacheTime[v] = time++;
+			misses++;
+		}
+	}
+
+	return (float) misses / (float) (indices.size() / 3);
+}
+
+// Reorders the triangles for the post-transform cache using Tipsify (Sander et al. 2007)
+void optimizeVertexCache(std::vector<unsigned int> &indices, const unsigned int vertexCount, const unsigned int cacheSize, std::vector<unsigned int> *clusters)
+{
+	const unsigned int indexCount = indices.size();
+	const unsigned int triangleCount = indexCount / 3;
+
+	// Count the triangles referencing each vertex (the live count)
+	std::vector<unsigned int> liveCount(vertexCount, 0);
+	for(const unsigned int v : indices)
+	{
+		liveCount[v]++;
+	}
+
+	// Build the vertex-triangle adjacency in one contiguous array
+	std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+	for(unsigned int v = 0; v < vertexCount; v++)
+	{
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveCount[v];
+	}
+	std::vector<unsigned int> adjacency(indexCount);
+	std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for(unsigned int i = 0; i < indexCount; i++)
+	{
+		adjacency[fill[indices[i]]++] = i / 3;
+	}
+
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> deadEndStack;
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> output;
+	deadEndStack.reserve(indexCount);
+	output.reserve(indexCount);
+
+	if(clusters)
+	{
+		clusters->clear();
+		clusters->push_back(0);
+	}
+
+	unsigned int time = cacheSize + 1;
+	unsigned int cursor = 0;
+	int fanningVertex = vertexCount > 0 ? 0 : -1;
+	while(fanningVertex >= 0)
+	{
+		// Emit all remaining triangles around the fanning vertex
+		candidates.clear();
+		for(unsigned int k = adjacencyOffsets[fanningVertex]; k < adjacencyOffsets[fanningVertex + 1]; k++)
+		{
+			const unsigned int t = adjacency[k];
+			if(emitted[t]) continue;
+
+			for(int j = 0; j < 3; j++)
+			{
+				const unsigned int v = indices[t * 3 + j];
+				output.push_back(v);
+				deadEndStack.push_back(v);
+				candidates.push_back(v);
+				liveCount[v]--;
+				if(time - cacheTime[v] > cacheSize)
+				{
+					cacheTime[v] = time++;
+				}
+			}
+			emitted[t] = true;
+		}
+
+		// Pick the candidate that will still be in the cache after its remaining triangles are emitted,
+		// preferring the one that has been in the cache the longest
+		int nextVertex = -1;
+		int bestPriority = -1;
+		for(const unsigned int v : candidates)
+		{
+			if(liveCount[v] == 0) continue;
+
+			int priority = 0;
+			if(time - cacheTime[v] + 2 * liveCount[v] <= cacheSize)
+			{
+				priority = time - cacheTime[v];
+			}
+			if(priority > bestPriority)
+			{
+				bestPriority = priority;
+				nextVertex = v;
+			}
+		}
+
+		// Dead-end: fall back to a recently emitted vertex, and then to the next vertex in input order
+		if(nextVertex == -1)
+		{
+			while(!deadEndStack.empty())
+			{
+				const unsigned int v = deadEndStack.back();
+				deadEndStack.pop_back();
+				if(liveCount[v] > 0)
+				{
+					nextVertex = v;
+					break;
+				}
+			}
+
+			while(nextVertex == -1 && cursor < vertexCount)
+			{
+				if(liveCount[cursor] > 0)
+				{
+					nextVertex = cursor;
+				}
+				cursor++;
+			}
+
+			// A dead-end is a hard boundary between two clusters
+			if(nextVertex != -1 && clusters && clusters->back() != output.size())
+			{
+				clusters->push_back(output.size());
+			}
+		}
+
+		fanningVertex = nextVertex;
+	}
+
+	indices.swap(output);
+}
+
+// Sorts the clusters produced by optimizeVertexCache() so that outward facing clusters are drawn first
+void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<float> &vertexData, const unsigned int stride, const std::vector<unsigned int> &clusters)
+{
+	struct Cluster
+	{
+		unsigned int begin, end; // Index range
+		glm::vec3 centroid; // Area weighted centroid
+		glm::vec3 normal; // Area weighted normal
+		float area; // Surface area
+		float sortKey;
+	};
+
+	const unsigned int clusterCount = clusters.size();
+	if(clusterCount < 2) return;
+
+	// Calculate the centroid and average normal of every cluster
+	std::vector<Cluster> clusterData(clusterCount);
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for(unsigned int c = 0; c < clusterCount; c++)
+	{
+		Cluster &cluster = clusterData[c];
+		cluster.begin = clusters[c];
+		cluster.end = c + 1 < clusterCount ? clusters[c + 1] : indices.size();
+		cluster.centroid = glm::vec3(0.0f);
+		cluster.normal = glm::vec3(0.0f);
+		cluster.area = 0.0f;
+
+		for(unsigned int i = cluster.begin; i < cluster.end; i += 3)
+		{
+			const glm::vec3 p0 = glm::make_vec3(&vertexData[indices[i + 0] * stride]);
+			const glm::vec3 p1 = glm::make_vec3(&vertexData[indices[i + 1] * stride]);
+			const glm::vec3 p2 = glm::make_vec3(&vertexData[indices[i + 2] * stride]);
+			const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			const float area = glm::length(n) * 0.5f;
+			cluster.centroid += (p0 + p1 + p2) * (area / 3.0f);
+			cluster.normal += n;
+			cluster.area += area;
+		}
+
+		meshCentroid += cluster.centroid;
+		meshArea += cluster.area;
+		if(cluster.area > 0.0f) cluster.centroid /= cluster.area;
+	}
+	if(meshArea > 0.0f) meshCentroid /= meshArea;
+
+	// Clusters that face away from the center of the mesh are likely to occlude the rest of it
+	for(Cluster &cluster : clusterData)
+	{
+		const float normalLength = glm::length(cluster.normal);
+		cluster.sortKey = normalLength > 0.0f ? glm::dot(cluster.centroid - meshCentroid, cluster.normal / normalLength) : 0.0f;
+	}
+	std::stable_sort(clusterData.begin(), clusterData.end(), [](const Cluster &a, const Cluster &b) { return a.sortKey > b.sortKey; });
+
+	// Rebuild the index buffer in cluster order
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+	for(const Cluster &cluster : clusterData)
+	{
+		output.insert(output.end(), indices.begin() + cluster.begin, indices.begin() + cluster.end);
+	}
+	indices.swap(output);
+}
+
+// Reorders the vertices in the order they are first referenced by the index buffer
+void optimizeVertexFetch(std::vector<float> &vertexData, const unsigned int stride, std::vector<unsigned int> &indices)
+{
+	const unsigned int vertexCount = vertexData.size() / stride;
+	const unsigned int unused = ~0u;
+
+	std::vector<unsigned int> remap(vertexCount, unused);
+	std::vector<float> output;
+	output.reserve(vertexData.size());
+	unsigned int nextVertex = 0;
+	for(unsigned int &index : indices)
+	{
+		if(remap[index] == unused)
+		{
+			remap[index] = nextVertex++;
+			output.insert(output.end(), vertexData.begin() + index * stride, vertexData.begin() + (index + 1) * stride);
+		}
+		index = remap[index];
+	}
+
+	vertexData.swap(output);
+}
+
+// Runs all of the above on an interleaved mesh whose first three components are the vertex position
+MeshOptimizationStats optimizeMesh(std::vector<float> &vertexData, const unsigned int stride, std::vector<unsigned int> &indices, const bool sortForOverdraw)
+{
+	MeshOptimizationStats stats;
+	stats.vertexCountBefore = vertexData.size() / stride;
+	const unsigned int vertexCount = weldVertices(vertexData, stride, indices);
+	stats.acmrBefore = computeACMR(indices, vertexCount, MESH_CACHE_SIZE); // After welding, so it only measures the reordering
+
+	std::vector<unsigned int> clusters;
+	optimizeVertexCache(indices, vertexCount, MESH_CACHE_SIZE, &clusters);
+	if(sortForOverdraw)
+	{
+		optimizeOverdraw(indices, vertexData, stride, clusters);
+	}
+	optimizeVertexFetch(vertexData, stride, indices);
+
+	stats.vertexCountAfter = vertexData.size() / stride;
+	stats.acmrAfter = computeACMR(indices, stats.vertexCountAfter, MESH_CACHE_SIZE);
+	return stats;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+
+// Size of the simulated post-transform vertex cache (FIFO)
+#define MESH_CACHE_SIZE 16
+
+// Statistics reported by optimizeMesh()
+struct MeshOptimizationStats
+{
+	unsigned int vertexCountBefore, vertexCountAfter; // Unique vertices before and after welding
+	float acmrBefore, acmrAfter; // Average cache miss ratio (cache misses per triangle) of the welded mesh before and after reordering
+};
+
+// Merges bit-identical vertices and rewrites the index buffer to reference the merged vertices.
+// Returns the new vertex count.
+unsigned int weldVertices(std::vector<float> &vertexData, const unsigned int stride, std::vector<unsigned int> &indices);
+
+// Simulates a FIFO cache of 'cacheSize' entries and returns the average number of cache misses per triangle
+float computeACMR(const std::vector<unsigned int> &indices, const unsigned int vertexCount, const unsigned int cacheSize);
+
+// Reorders the triangles for the post-transform cache using Tipsify (Sander et al. 2007).
+// The offsets of the clusters separated by hard boundaries (dead-ends) are written to 'clusters' if given.
+void optimizeVertexCache(std::vector<unsigned int> &indices, const unsigned int vertexCount, const unsigned int cacheSize, std::vector<unsigned int> *clusters = 0);
+
+// Sorts the clusters produced by optimizeVertexCache() so that outward facing clusters are drawn first
+void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<float> &vertexData, const unsigned int stride, const std::vector<unsigned int> &clusters);
+
+// Reorders the vertices in the order they are first referenced by the index buffer
+void optimizeVertexFetch(std::vector<float> &vertexData, const unsigned int stride, std::vector<unsigned int> &indices);
+
+// Runs all of the above on an interleaved mesh whose first three components are the vertex position
+MeshOptimizationStats optimizeMesh(std::vector<float> &vertexData, const unsigned int stride, std::vector<unsigned int> &indices, const bool sortForOverdraw);
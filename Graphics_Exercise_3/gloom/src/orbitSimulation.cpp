@@ -0,0 +1,105 @@
+#include "orbitSimulation.hpp"
+
+#include <cmath>
+
+OrbitSimulation createOrbitSimulation()
+{
+	OrbitSimulation simulation;
+	simulation.count = 0;
+	return simulation;
+}
+
+unsigned int addOrbitBody(OrbitSimulation &simulation, const glm::vec3 &axis, const float speed, const glm::mat4 &baseMatrix)
+{
+	const glm::vec3 normalizedAxis = glm::normalize(axis);
+	simulation.angle.push_back(0.0);
+	simulation.speed.push_back(speed);
+	simulation.axisX.push_back(normalizedAxis.x);
+	simulation.axisY.push_back(normalizedAxis.y);
+	simulation.axisZ.push_back(normalizedAxis.z);
+	simulation.baseMatrices.push_back(baseMatrix);
+	return simulation.count++;
+}
+
+void advanceOrbits(OrbitSimulation &simulation, const unsigned int first, const unsigned int count, const float dt)
+{
+	const double twoPi = 2.0 * PI;
+	double *angle = simulation.angle.data();
+	const float *speed = simulation.speed.data();
+	for(unsigned int i = first; i < first + count; i++)
+	{
+		// Wrap the angle so it keeps its precision however long the simulation runs
+		double a = angle[i] + (double) speed[i] * dt;
+		a -= twoPi * floor(a / twoPi + 0.5);
+		angle[i] = a;
+	}
+}
+
+// Writes rotate(angle, axis) * baseMatrix into 'matrix' given the sine and cosine of the angle (Rodrigues' formula)
+static inline void composeOrbitMatrix(const float s, const float c, const float x, const float y, const float z, const glm::mat4 &baseMatrix, glm::mat4 &matrix)
+{
+	// Rotation matrix R = c * I + s * [axis]x + (1 - c) * axis * axis^T (r[row][column])
+	const float t = 1.0f - c;
+	const float r00 = c + t * x * x,     r01 = t * x * y - s * z, r02 = t * x * z + s * y;
+	const float r10 = t * x * y + s * z, r11 = c + t * y * y,     r12 = t * y * z - s * x;
+	const float r20 = t * x * z - s * y, r21 = t * y * z + s * x, r22 = c + t * z * z;
+
+	// Every column of the base matrix is rotated, w is unchanged
+	for(int column = 0; column < 4; column++)
+	{
+		const glm::vec4 &b = baseMatrix[column];
+		matrix[column] = glm::vec4(r00 * b.x + r01 * b.y + r02 * b.z,
+		                           r10 * b.x + r11 * b.y + r12 * b.z,
+		                           r20 * b.x + r21 * b.y + r22 * b.z, b.w);
+	}
+}
+
+#ifdef ORBIT_SIMULATION_SSE
+
+void computeOrbitMatrices(const OrbitSimulation &simulation, const unsigned int first, const unsigned int count, const float timeOffset, glm::mat4 *matrices)
+{
+	const double *angle = simulation.angle.data() + first;
+	const float *speed = simulation.speed.data() + first;
+	const float *axisX = simulation.axisX.data() + first;
+	const float *axisY = simulation.axisY.data() + first;
+	const float *axisZ = simulation.axisZ.data() + first;
+	const glm::mat4 *baseMatrices = simulation.baseMatrices.data() + first;
+	const __m128 offset = _mm_set1_ps(timeOffset);
+
+	// Four bodies at a time
+	unsigned int i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128 sine, cosine;
+		const __m128 angles = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(angle + i)), _mm_cvtpd_ps(_mm_loadu_pd(angle + i + 2)));
+		sincos4(_mm_add_ps(angles, _mm_mul_ps(_mm_loadu_ps(speed + i), offset)), sine, cosine);
+
+		float s[4], c[4];
+		_mm_storeu_ps(s, sine);
+		_mm_storeu_ps(c, cosine);
+		for(int k = 0; k < 4; k++)
+		{
+			composeOrbitMatrix(s[k], c[k], axisX[i + k], axisY[i + k], axisZ[i + k], baseMatrices[i + k], matrices[i + k]);
+		}
+	}
+
+	// Remaining bodies
+	for(; i < count; i++)
+	{
+		const float a = (float) angle[i] + speed[i] * timeOffset;
+		composeOrbitMatrix(sinf(a), cosf(a), axisX[i], axisY[i], axisZ[i], baseMatrices[i], matrices[i]);
+	}
+}
+
+#else
+
+void computeOrbitMatrices(const OrbitSimulation &simulation, const unsigned int first, const unsigned int count, const float timeOffset, glm::mat4 *matrices)
+{
+	for(unsigned int i = first; i < first + count; i++)
+	{
+		const float a = (float) simulation.angle[i] + simulation.speed[i] * timeOffset;
+		composeOrbitMatrix(sinf(a), cosf(a), simulation.axisX[i], simulation.axisY[i], simulation.axisZ[i], simulation.baseMatrices[i], matrices[i - first]);
+	}
+}
+
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "simdMath.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#ifndef PI
+	#define PI 3.14159265
+#endif
+
+// Use the SSE kernel when the target supports SSE2 (define ORBIT_SIMULATION_SCALAR to force the scalar path)
+#if !defined(ORBIT_SIMULATION_SCALAR) && defined(SIMD_MATH_SSE)
+	#define ORBIT_SIMULATION_SSE 1
+#endif
+
+// Orbiting bodies, stored as a structure of arrays. Every body keeps its orbit angle instead of accumulating
+// rotations into its matrix, so its matrix is rebuilt exactly from the angle every time and never drifts.
+// A body's (parent relative) matrix is rotate(angle, axis) * baseMatrix.
+struct OrbitSimulation
+{
+	unsigned int count; // Number of bodies
+	std::vector<double> angle; // Orbit angle (radians, kept in [-pi, pi]). Double, so that adding small steps doesn't lose precision.
+	std::vector<float> speed; // Orbit speed (radians per second)
+	std::vector<float> axisX, axisY, axisZ; // Normalized rotation axis
+	std::vector<glm::mat4> baseMatrices; // Matrix at angle 0
+};
+
+// Creates an empty simulation
+OrbitSimulation createOrbitSimulation();
+
+// Adds a body orbiting around 'axis' at 'speed' radians per second, and returns its index
+unsigned int addOrbitBody(OrbitSimulation &simulation, const glm::vec3 &axis, const float speed, const glm::mat4 &baseMatrix);
+
+// Advances the orbit angles of the bodies [first, first + count) by 'dt' seconds
+void advanceOrbits(OrbitSimulation &simulation, const unsigned int first, const unsigned int count, const float dt);
+
+// Writes the matrices of the bodies [first, first + count), 'timeOffset' seconds from their current angle
+// (used to interpolate between simulation ticks), to 'matrices[0 .. count)'
+void computeOrbitMatrices(const OrbitSimulation &simulation, const unsigned int first, const unsigned int count, const float timeOffset, glm::mat4 *matrices);
@@ -2,13 +2,20 @@
 #include "program.hpp"
 #include "sceneGraph.hpp"
 #include "sphere.hpp"
+#include "timestep.hpp"
+#include "jobSystem.hpp"
+#include "orbitSimulation.hpp"
+#include "lightClusters.hpp"
 #include "gloom/gloom.hpp"
 #include "gloom/shader.hpp"
 
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <unordered_map>
+
 // Enum of keyboard input actions
 enum Action
 {
@@ -27,14 +34,19 @@ bool actionState[ACTION_COUNT];
 // Value storing the previous cursor position
 glm::vec2 previousCursorPos(0.0f);
 
-// Camera movement and rotation speed constants
-const float moveSpeed = 0.05f;
+// Camera movement (units per second) and rotation speed constants
+const float moveSpeed = 3.0f;
 const float rotationSpeed = 0.1f;
 
+// Simulation tick rate, and the maximum render frame rate (0 = uncapped)
+const double simulationTickRate = 60.0;
+const double maxFrameRate = 0.0;
+
 // Camera struct
 struct
 {
 	glm::vec3 position; // Camera position
+	glm::vec3 previousPosition; // Camera position at the previous simulation tick
 	float pitch, yaw;   // Camera orientation (pitch and yaw)
 } camera;
 
@@ -42,6 +54,47 @@ struct
 #define SPHERE_SLICES 10
 #define SPHERE_LAYERS 10
 
+// Number of asteroids in the belt between planet 4 and 5, and the radius range of the belt
+#define ASTEROID_COUNT 2000
+#define ASTEROID_BELT_INNER_RADIUS 35.0f
+#define ASTEROID_BELT_OUTER_RADIUS 45.0f
+
+// Every asteroid carries a point light of this radius, and the sun lights the whole system
+#define ASTEROID_LIGHT_RADIUS 4.0f
+#define SUN_LIGHT_RADIUS 150.0f
+
+// Orbits of the scene nodes (body i belongs to the i-th node of the flattened scene graph),
+// and the matrices they were last evaluated to
+OrbitSimulation orbits;
+std::vector<glm::mat4> orbitMatrices;
+
+// Per instance data of a node (matches the instance buffer in simple.vert, std430 layout)
+struct SceneInstance
+{
+	glm::mat4 modelViewProjection;
+	glm::mat4 model; // Cumulative model transformation
+	glm::vec4 normalMatrix[3]; // Inverse transpose of the model matrix (mat3 columns are padded to vec4)
+};
+
+// Index of the parent of every node of the flattened scene graph (-1 for the root),
+// and the instance data of every node, uploaded to 'instanceBuffer' every frame
+std::vector<int> parentIndices;
+std::vector<SceneInstance> sceneInstances;
+GLuint instanceBuffer;
+
+// Nodes that carry a point light and the light colours (filled in by createScene()), the index of every such node
+// in the flattened scene graph, and the lights, their cluster grid and the buffers they are uploaded to every frame
+std::vector<SceneNode*> lightNodes;
+std::vector<glm::vec3> lightColors;
+std::vector<unsigned int> lightNodeIndices;
+std::vector<PointLight> pointLights;
+LightClusterGrid lightClusterGrid;
+GLuint lightBuffer, clusterBuffer, lightIndexBuffer;
+
+// Shade every light for every fragment instead of using the clusters (toggled with L), to check that both look the
+// same (tools/lightingBenchmark compares their speed)
+bool shadeAllLights = false;
+
 // Sets up the initial model transformation for the nodes in the scene
 void initTransformationMatrix(SceneNode *node)
 {
@@ -72,6 +125,8 @@ SceneNode *createScene()
 	sun->rotationDirection = glm::vec3(0.0f, 1.0f, 0.0f);
 	sun->rotationSpeedRadians = 0.0f;
 	sun->rotationX = PI * 0.5f;
+	lightNodes.push_back(sun);
+	lightColors.push_back(glm::vec3(1.0f));
 
 	// Planet 1
 	{
@@ -161,59 +216,212 @@ SceneNode *createScene()
 		}
 	}
 
+	// Asteroid belt, sharing one VAO
+	const int asteroidVAO = createCircleVAO(SPHERE_SLICES, SPHERE_LAYERS, glm::vec4(0.6f, 0.55f, 0.5f, 1.0f));
+	for(int i = 0; i < ASTEROID_COUNT; i++)
+	{
+		SceneNode *asteroid = createSceneNode();
+		asteroid->vertexArrayObjectID = asteroidVAO;
+		asteroid->x = ASTEROID_BELT_INNER_RADIUS + random() * (ASTEROID_BELT_OUTER_RADIUS - ASTEROID_BELT_INNER_RADIUS);
+		asteroid->y = (random() - 0.5f) * 2.0f;
+		asteroid->scaleFactor = 0.05f + random() * 0.1f;
+		asteroid->rotationZ = random() * 2.0f * PI; // Start angle along the belt
+		asteroid->rotationDirection = glm::vec3((random() - 0.5f) * 0.05f, (random() - 0.5f) * 0.05f, 1.0f);
+		asteroid->rotationSpeedRadians = 2.0f * PI * (0.05f + random() * 0.1f);
+		addChild(sun, asteroid);
+		lightNodes.push_back(asteroid);
+		lightColors.push_back(glm::vec3(random(), random(), random()) * 0.5f);
+	}
+
 	initTransformationMatrix(sun);
 
 	return sun;
 }
 
-// Updates the scene recursively
-void updateScene(SceneNode *node, const float dt)
+// Number of nodes per scene update job
+#define UPDATE_JOB_SIZE 1024
+
+// Creates an orbit for every node of the flattened scene graph, starting from the node's initial matrix
+void createOrbits(const std::vector<SceneNode*> &nodes)
 {
-	if(node)
+	orbits = createOrbitSimulation();
+	for(SceneNode *node : nodes)
 	{
-		// Apply rotation to the model matrix
-		node->currentTransformationMatrix = glm::rotate(node->rotationSpeedRadians * dt, node->rotationDirection) * node->currentTransformationMatrix;
+		addOrbitBody(orbits, node->rotationDirection, node->rotationSpeedRadians, node->currentTransformationMatrix);
+	}
+	orbitMatrices.resize(nodes.size());
+}
 
-		// Update children
-		for(SceneNode *child : node->children)
+// Creates the instance data of the flattened scene graph
+void createSceneInstances(const std::vector<SceneNode*> &nodes)
+{
+	std::unordered_map<SceneNode*, int> nodeIndices;
+	for(unsigned int i = 0; i < nodes.size(); i++)
+	{
+		nodeIndices[nodes[i]] = i;
+	}
+	parentIndices.assign(nodes.size(), -1);
+	for(unsigned int i = 0; i < nodes.size(); i++)
+	{
+		for(SceneNode *child : nodes[i]->children)
 		{
-			updateScene(child, dt);
+			parentIndices[nodeIndices[child]] = i;
 		}
 	}
+
+	sceneInstances.resize(nodes.size());
+	glGenBuffers(1, &instanceBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sceneInstances.size() * sizeof(SceneInstance), 0, GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
-// Draws the scene recursively
-void drawScene(SceneNode *node, std::stack<glm::mat4> *matrixStack, glm::mat4 cumulativeModelTransformation = glm::mat4())
+// Creates the point lights of the light carrying nodes, and the buffers the lights and their clusters are uploaded to
+void createLights(const std::vector<SceneNode*> &nodes, const float fovY, const float aspect, const float nearPlane, const float farPlane)
 {
-	if(node)
+	std::unordered_map<SceneNode*, unsigned int> nodeIndices;
+	for(unsigned int i = 0; i < nodes.size(); i++)
+	{
+		nodeIndices[nodes[i]] = i;
+	}
+	pointLights.resize(lightNodes.size());
+	lightNodeIndices.resize(lightNodes.size());
+	for(unsigned int i = 0; i < lightNodes.size(); i++)
 	{
-		// Apply the model transformation matrix to the topmost matrix on the stack
-		glm::mat4 modelViewProjection = peekMatrix(matrixStack) * node->currentTransformationMatrix;
+		lightNodeIndices[i] = nodeIndices[lightNodes[i]];
+		pointLights[i].positionRadius = glm::vec4(0.0f, 0.0f, 0.0f, i == 0 ? SUN_LIGHT_RADIUS : ASTEROID_LIGHT_RADIUS);
+		pointLights[i].color = glm::vec4(lightColors[i], 0.0f);
+	}
+	lightClusterGrid = createLightClusterGrid(fovY, aspect, nearPlane, farPlane);
 
-		// This cumulative model transformation is used to apply phong shading correclty
-		cumulativeModelTransformation = cumulativeModelTransformation * node->currentTransformationMatrix;
+	GLuint buffers[3];
+	glGenBuffers(3, buffers);
+	lightBuffer = buffers[0];
+	clusterBuffer = buffers[1];
+	lightIndexBuffer = buffers[2];
+}
 
-		// Feed the mvp and model matrix to our shader program
-		glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(modelViewProjection));
-		glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(cumulativeModelTransformation));
+// Moves the lights to their nodes and rebuilds the light lists of the clusters, after evaluateScene()
+void updateLights(const glm::mat4 &viewMatrix)
+{
+	parallelFor(pointLights.size(), UPDATE_JOB_SIZE, [&](const unsigned int begin, const unsigned int end)
+	{
+		for(unsigned int i = begin; i < end; i++)
+		{
+			const glm::vec3 position = glm::vec3(sceneInstances[lightNodeIndices[i]].model[3]);
+			pointLights[i].positionRadius = glm::vec4(position, pointLights[i].positionRadius.w);
+		}
+	});
+	buildLightClusters(lightClusterGrid, pointLights.data(), pointLights.size(), viewMatrix);
+}
 
-		// Draw scene node
-		glBindVertexArray(node->vertexArrayObjectID);
-		glDrawElements(GL_TRIANGLES, SPHERE_SLICES * SPHERE_LAYERS * 2 * 3, GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
+// Uploads the lights and their clusters, and sets the lighting uniforms of the active shader
+void uploadLights(const glm::mat4 &viewMatrix, const int framebufferWidth, const int framebufferHeight)
+{
+	// The buffers are respecified every frame, so the driver can hand out new storage instead of waiting for the GPU
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, pointLights.size() * sizeof(PointLight), pointLights.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusterBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, lightClusterGrid.clusters.size() * sizeof(glm::uvec2), lightClusterGrid.clusters.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightIndexBuffer);
+	const std::vector<uint32_t> &indices = lightClusterGrid.lightIndices;
+	glBufferData(GL_SHADER_STORAGE_BUFFER, glm::max<size_t>(indices.size(), 1) * sizeof(uint32_t), indices.empty() ? 0 : indices.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, lightBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, clusterBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, lightIndexBuffer);
+
+	glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(viewMatrix));
+	glUniform4f(2, (float) LIGHT_CLUSTERS_X / framebufferWidth, (float) LIGHT_CLUSTERS_Y / framebufferHeight,
+		lightClusterGrid.sliceScale, lightClusterGrid.sliceBias);
+	glUniform1ui(3, pointLights.size());
+	glUniform1i(4, shadeAllLights);
+}
 
-		// Push current matrix on stack
-		pushMatrix(matrixStack, modelViewProjection);
+// Advances the scene by one simulation tick. Only the orbit angles are advanced, the matrices are
+// rebuilt from the angles when the scene is drawn, so no rounding error builds up in them.
+void updateScene(const std::vector<SceneNode*> &nodes, const float dt)
+{
+	parallelFor(nodes.size(), UPDATE_JOB_SIZE, [&](const unsigned int begin, const unsigned int end)
+	{
+		advanceOrbits(orbits, begin, end - begin, dt);
+	});
+}
 
-		// Draw children
-		for(SceneNode *child : node->children)
+// Evaluates the (parent relative) matrix of every node 'timeOffset' (<= 0) seconds from the current
+// simulation tick, which places the rendered state between the last two ticks. Then computes the instance
+// data of every node, so the shaders don't need to invert matrices per vertex or fragment.
+void evaluateScene(const std::vector<SceneNode*> &nodes, const float timeOffset, const glm::mat4 &viewProjectionMatrix)
+{
+	parallelFor(nodes.size(), UPDATE_JOB_SIZE, [&](const unsigned int begin, const unsigned int end)
+	{
+		computeOrbitMatrices(orbits, begin, end - begin, timeOffset, &orbitMatrices[begin]);
+		for(unsigned int i = begin; i < end; i++)
 		{
-			drawScene(child, matrixStack, cumulativeModelTransformation);
+			nodes[i]->currentTransformationMatrix = orbitMatrices[i];
 		}
+	});
 
-		// Pop current matrix from stack
-		popMatrix(matrixStack);
+	// The parents of a node can be in any job, so the cumulative matrices are computed once all the node matrices are done
+	parallelFor(nodes.size(), UPDATE_JOB_SIZE, [&](const unsigned int begin, const unsigned int end)
+	{
+		for(unsigned int i = begin; i < end; i++)
+		{
+			// The scene graph is shallow, so walking up to the root is cheap
+			glm::mat4 model = orbitMatrices[i];
+			for(int parent = parentIndices[i]; parent >= 0; parent = parentIndices[parent])
+			{
+				model = orbitMatrices[parent] * model;
+			}
+
+			SceneInstance &instance = sceneInstances[i];
+			instance.modelViewProjection = viewProjectionMatrix * model;
+			instance.model = model;
+			const glm::mat3 normalMatrix = glm::inverseTranspose(glm::mat3(model));
+			for(int column = 0; column < 3; column++)
+			{
+				instance.normalMatrix[column] = glm::vec4(normalMatrix[column], 0.0f);
+			}
+		}
+	});
+}
+
+// Advances the camera by one simulation tick
+void updateCamera(const float dt, const glm::vec3 &fwd, const glm::vec3 &right, const glm::vec3 &up)
+{
+	// Remember where the camera was, so we can interpolate between the last two ticks
+	camera.previousPosition = camera.position;
+
+	// Move the camera relative to the direction it is facing
+	camera.position += right * float((actionState[MOVE_RIGHT] - actionState[MOVE_LEFT]) * moveSpeed * dt);
+	camera.position += up * float((actionState[MOVE_UP] - actionState[MOVE_DOWN]) * moveSpeed * dt);
+	camera.position += fwd * float((actionState[MOVE_BACKWARD] - actionState[MOVE_FORWARD]) * moveSpeed * dt);
+}
+
+// Uploads the instance data and draws the scene. Consecutive nodes that share a VAO (like the asteroids)
+// are drawn with one instanced draw call.
+void drawScene(const std::vector<SceneNode*> &nodes)
+{
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sceneInstances.size() * sizeof(SceneInstance), sceneInstances.data());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+
+	for(unsigned int first = 0; first < nodes.size(); )
+	{
+		unsigned int last = first + 1;
+		while(last < nodes.size() && nodes[last]->vertexArrayObjectID == nodes[first]->vertexArrayObjectID)
+		{
+			last++;
+		}
+
+		// Draw scene nodes
+		glUniform1ui(0, first);
+		glBindVertexArray(nodes[first]->vertexArrayObjectID);
+		glDrawElementsInstanced(GL_TRIANGLES, SPHERE_SLICES * SPHERE_LAYERS * 2 * 3, GL_UNSIGNED_INT, 0, last - first);
+		first = last;
 	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
 void runProgram(GLFWwindow* window)
@@ -237,6 +445,10 @@ void runProgram(GLFWwindow* window)
 
 	// Create scene
 	SceneNode *root = createScene();
+	std::vector<SceneNode*> sceneNodes;
+	flattenSceneGraph(root, sceneNodes);
+	createOrbits(sceneNodes);
+	createSceneInstances(sceneNodes);
 
 	// Load our shader
 	Gloom::Shader shader;
@@ -248,13 +460,22 @@ void runProgram(GLFWwindow* window)
 	camera.position.x = -15.0f;
 	camera.position.y = 3.2f;
 	camera.position.z = 9.3f;
+	camera.previousPosition = camera.position;
 	camera.pitch = 9.0f;
 	camera.yaw = 146.5f;
 
+	// Run the simulation at a fixed rate, independently of the render frame rate
+	FixedTimestep timestep = createFixedTimestep(simulationTickRate);
+	glfwSwapInterval(0);
+	getTimeDeltaSeconds();
+
 	// Calculate projection matrix
 	int width, height;
 	glfwGetWindowSize(window, &width, &height);
 	glm::mat4 projectionMatrix = glm::perspective(1.0f, (float) width / (float) height, 1.0f, 100.0f);
+	createLights(sceneNodes, 1.0f, (float) width / (float) height, 1.0f, 100.0f);
+	int framebufferWidth, framebufferHeight;
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
 
     // Rendering Loop
     while (!glfwWindowShouldClose(window))
@@ -262,9 +483,6 @@ void runProgram(GLFWwindow* window)
         // Clear colour and depth buffers
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// Update scene
-		updateScene(root, getTimeDeltaSeconds());
-
 		// Calculate the camera's forward, right and up vector from the yaw and pitch
 		glm::vec3 fwd;
 		fwd.x = cos(glm::radians(camera.pitch)) * cos(glm::radians(camera.yaw));
@@ -273,10 +491,18 @@ void runProgram(GLFWwindow* window)
 		glm::vec3 right = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), fwd));
 		glm::vec3 up = glm::cross(fwd, right);
 
-		// Move the camera relative to the direction it is facing
-		camera.position += right * float((actionState[MOVE_RIGHT] - actionState[MOVE_LEFT]) * moveSpeed);
-		camera.position += up * float((actionState[MOVE_UP] - actionState[MOVE_DOWN]) * moveSpeed);
-		camera.position += fwd * float((actionState[MOVE_BACKWARD] - actionState[MOVE_FORWARD]) * moveSpeed);
+		// Update scene in fixed simulation ticks
+		advanceFixedTimestep(timestep, getTimeDeltaSeconds());
+		while(consumeTick(timestep))
+		{
+			updateScene(sceneNodes, (float) timestep.tickSeconds);
+			updateCamera((float) timestep.tickSeconds, fwd, right, up);
+		}
+
+		// Render the state between the last two simulation ticks
+		const float alpha = getInterpolationAlpha(timestep);
+		const float timeOffset = (alpha - 1.0f) * (float) timestep.tickSeconds;
+		const glm::vec3 cameraPosition = glm::mix(camera.previousPosition, camera.position, alpha);
 
 		glm::mat4 eyeSpaceMatrix(
 			right.x, up.x, fwd.x, 0.0f,
@@ -284,19 +510,18 @@ void runProgram(GLFWwindow* window)
 			right.z, up.z, fwd.z, 0.0f,
 			0.0f, 0.0f, 0.0f, 1.0f);
 
-		// Calcualte our projection matrix
-		glm::mat4 viewProjectionMatrix;
-		viewProjectionMatrix = eyeSpaceMatrix * viewProjectionMatrix;					// mvp = eyeSpaceMatrix
-		viewProjectionMatrix = glm::translate(viewProjectionMatrix, -camera.position);	// mvp = eyeSpaceMatrix * centerCameraMatrix
-		viewProjectionMatrix = projectionMatrix * viewProjectionMatrix;					// mvp = projectionMatrix * eyeSpaceMatrix * centerCameraMatrix
-
-		// Push our projection matrix onto the matrix stack
-		std::stack<glm::mat4> *matrixStack = createEmptyMatrixStack();
-		pushMatrix(matrixStack, viewProjectionMatrix);
+		// Calcualte our view and projection matrix
+		glm::mat4 viewMatrix;
+		viewMatrix = eyeSpaceMatrix * viewMatrix;								// view = eyeSpaceMatrix
+		viewMatrix = glm::translate(viewMatrix, -cameraPosition);				// view = eyeSpaceMatrix * centerCameraMatrix
+		glm::mat4 viewProjectionMatrix = projectionMatrix * viewMatrix;			// mvp = projectionMatrix * eyeSpaceMatrix * centerCameraMatrix
 
 		// Draw scene
+		evaluateScene(sceneNodes, timeOffset, viewProjectionMatrix);
+		updateLights(viewMatrix);
 		shader.activate();
-		drawScene(root, matrixStack);
+		uploadLights(viewMatrix, framebufferWidth, framebufferHeight);
+		drawScene(sceneNodes);
 		shader.deactivate();
 
         // Handle other events
@@ -304,9 +529,16 @@ void runProgram(GLFWwindow* window)
 
         // Flip buffers
         glfwSwapBuffers(window);
+
+		// Throttle rendering (the simulation rate is unaffected)
+		limitFrameRate(maxFrameRate);
     }
 
 	shader.destroy();
+	glDeleteBuffers(1, &instanceBuffer);
+	glDeleteBuffers(1, &lightBuffer);
+	glDeleteBuffers(1, &clusterBuffer);
+	glDeleteBuffers(1, &lightIndexBuffer);
 }
 
 void keyboardCallback(GLFWwindow* window, int key, int scancode,
@@ -325,6 +557,9 @@ void keyboardCallback(GLFWwindow* window, int key, int scancode,
 	else if(key == GLFW_KEY_LEFT_SHIFT) actionState[MOVE_DOWN] = action != GLFW_RELEASE;
 	else if(key == GLFW_KEY_W) actionState[MOVE_FORWARD] = action != GLFW_RELEASE;
 	else if(key == GLFW_KEY_S) actionState[MOVE_BACKWARD] = action != GLFW_RELEASE;
+
+	// Toggle between the clustered lights and shading every light
+	if(key == GLFW_KEY_L && action == GLFW_PRESS) shadeAllLights = !shadeAllLights;
 }
 
 void cursorPosCallback(GLFWwindow* window, double x, double y)
@@ -59,6 +59,19 @@ void addChild(SceneNode* parent, SceneNode* child) {
 	parent->children.push_back(child);
 }
 
+// Appends 'node' and all of its descendants to 'nodes'
+void flattenSceneGraph(SceneNode *node, std::vector<SceneNode*> &nodes)
+{
+	if(node)
+	{
+		nodes.push_back(node);
+		for(SceneNode *child : node->children)
+		{
+			flattenSceneGraph(child, nodes);
+		}
+	}
+}
+
 // Pretty prints the current values of a SceneNode instance to stdout
 void printNode(SceneNode* node) {
 	printf(
@@ -60,6 +60,7 @@ typedef struct SceneNode {
 
 SceneNode* createSceneNode();
 void addChild(SceneNode* parent, SceneNode* child);
+void flattenSceneGraph(SceneNode *node, std::vector<SceneNode*> &nodes);
 void printNode(SceneNode* node);
 
 // Utility functions
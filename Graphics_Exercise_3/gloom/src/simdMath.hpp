@@ -0,0 +1,63 @@
+#pragma once
+
+// SIMD helpers shared by the batch kernels. This file is kept identical in Graphics_Project and Graphics_Exercise_3
+// (the projects are built on their own, each with its own copy of gloom), so a fix here has to go into both copies.
+
+// SSE2 is available (x64 always has it). Kernels that use it also check their own *_SCALAR define, which forces their
+// scalar path.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SIMD_MATH_SSE 1
+#endif
+
+#ifdef SIMD_MATH_SSE
+
+#include <emmintrin.h>
+
+// Computes the sine and cosine of four angles at once (Cephes sinf/cosf range reduction and polynomials)
+inline void sincos4(__m128 x, __m128 &sine, __m128 &cosine)
+{
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+
+	// Work with |x| and remember the sign of the sine
+	__m128 sineSign = _mm_and_ps(x, signMask);
+	x = _mm_andnot_ps(signMask, x);
+
+	// Find the octant: j = (int(x * 4 / pi) + 1) & ~1
+	__m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+	j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+	const __m128 y = _mm_cvtepi32_ps(j);
+
+	// Octants 4-7 flip the sign of the sine, octants 2-5 flip the sign of the cosine,
+	// and octants 2, 3, 6 and 7 swap the sine and cosine polynomials
+	sineSign = _mm_xor_ps(sineSign, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29)));
+	const __m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+	const __m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+
+	// Extended precision modular arithmetic: x = x - y * pi / 4
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+	const __m128 z = _mm_mul_ps(x, x);
+
+	// Cosine polynomial on [-pi/4, pi/4]
+	__m128 cosPoly = _mm_set1_ps(2.443315711809948e-5f);
+	cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(-1.388731625493765e-3f));
+	cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(4.166664568298827e-2f));
+	cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+	cosPoly = _mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+	cosPoly = _mm_add_ps(cosPoly, _mm_set1_ps(1.0f));
+
+	// Sine polynomial on [-pi/4, pi/4]
+	__m128 sinPoly = _mm_set1_ps(-1.9515295891e-4f);
+	sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(8.3321608736e-3f));
+	sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(-1.6666654611e-1f));
+	sinPoly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), x), x);
+
+	// Select the polynomials for each octant and apply the signs
+	sine = _mm_or_ps(_mm_and_ps(polyMask, sinPoly), _mm_andnot_ps(polyMask, cosPoly));
+	cosine = _mm_or_ps(_mm_and_ps(polyMask, cosPoly), _mm_andnot_ps(polyMask, sinPoly));
+	sine = _mm_xor_ps(sine, sineSign);
+	cosine = _mm_xor_ps(cosine, cosineSign);
+}
+
+#endif
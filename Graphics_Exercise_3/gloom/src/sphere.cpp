@@ -1,24 +1,37 @@
 #include "sphere.hpp"
+#include "meshOptimizer.hpp"
+
+// Interleaved (xyzrgba nxnynz) vertex stride
+#define VERTEX_STRIDE 10
 
 GLuint generateVertexArray(float *vertices, float *colors, unsigned int *indices, const unsigned int triangleCount)
 {
-	// Create continous (xyzrgba) interleaved vertex data pointer
+	// Create continous (xyzrgba nxnynz) interleaved vertex data
 	const unsigned int vertexCount = triangleCount * 3;
-	const unsigned int vertexDataSize = (3 + 4) * vertexCount;
-	float *vertexData = new float[vertexDataSize];
+	std::vector<float> vertexData(VERTEX_STRIDE * vertexCount);
 	for(unsigned int i = 0; i < vertexCount; i++)
 	{
 		// Write xyz
-		vertexData[i * 7 + 0] = vertices[i * 3 + 0];
-		vertexData[i * 7 + 1] = vertices[i * 3 + 1];
-		vertexData[i * 7 + 2] = vertices[i * 3 + 2];
+		vertexData[i * VERTEX_STRIDE + 0] = vertices[i * 3 + 0];
+		vertexData[i * VERTEX_STRIDE + 1] = vertices[i * 3 + 1];
+		vertexData[i * VERTEX_STRIDE + 2] = vertices[i * 3 + 2];
 
 		// Write rgba
-		vertexData[i * 7 + 3] = colors[i * 4 + 0];
-		vertexData[i * 7 + 4] = colors[i * 4 + 1];
-		vertexData[i * 7 + 5] = colors[i * 4 + 2];
-		vertexData[i * 7 + 6] = colors[i * 4 + 3];
+		vertexData[i * VERTEX_STRIDE + 3] = colors[i * 4 + 0];
+		vertexData[i * VERTEX_STRIDE + 4] = colors[i * 4 + 1];
+		vertexData[i * VERTEX_STRIDE + 5] = colors[i * 4 + 2];
+		vertexData[i * VERTEX_STRIDE + 6] = colors[i * 4 + 3];
+
+		// Write the normal (the position, since the sphere has a radius of 1)
+		const glm::vec3 normal = glm::normalize(glm::vec3(vertices[i * 3 + 0], vertices[i * 3 + 1], vertices[i * 3 + 2]));
+		vertexData[i * VERTEX_STRIDE + 7] = normal.x;
+		vertexData[i * VERTEX_STRIDE + 8] = normal.y;
+		vertexData[i * VERTEX_STRIDE + 9] = normal.z;
 	}
+	std::vector<unsigned int> indexData(indices, indices + vertexCount);
+
+	// Weld the duplicated vertices and reorder the triangles for the post-transform cache
+	optimizeMesh(vertexData, VERTEX_STRIDE, indexData, false);
 
 	// Generate and bind Vertex Array Object
 	GLuint vaoID, vboID, iboID;
@@ -28,18 +41,20 @@ GLuint generateVertexArray(float *vertices, float *colors, unsigned int *indices
 	// Generate Vertex Buffer Object and upload the vertex data
 	glGenBuffers(1, &vboID);
 	glBindBuffer(GL_ARRAY_BUFFER, vboID);
-	glBufferData(GL_ARRAY_BUFFER, vertexDataSize * sizeof(float), vertexData, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STATIC_DRAW);
 
 	// Set and enable vertex attribute pointers for the VBO
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, (3 + 4) * sizeof(float), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, (3 + 4) * sizeof(float), (void*) (3 * sizeof(float)));
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_STRIDE * sizeof(float), 0);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, VERTEX_STRIDE * sizeof(float), (void*) (3 * sizeof(float)));
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, VERTEX_STRIDE * sizeof(float), (void*) (7 * sizeof(float)));
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
 
 	// Generate Index Buffer Object and upload the index data
 	glGenBuffers(1, &iboID);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboID);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, vertexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size() * sizeof(unsigned int), indexData.data(), GL_STATIC_DRAW);
 
 	// Unbind VAO
 	glBindVertexArray(0);
@@ -71,7 +86,8 @@ unsigned int createCircleVAO(unsigned int slices, unsigned int layers, glm::vec4
 	const float degreesPerSlice = 360.0 / (float) slices;
 
 	// Keeping track of the triangle index in the buffer. 
-	// This implementation is fairly naive in the sense that it does not reuse vertices with the index buffer.
+	// This implementation is fairly naive in the sense that it does not reuse vertices with the index buffer,
+	// the duplicated vertices are welded by generateVertexArray().
 	int i = 0;
 
 	// Constructing the sphere one layer at a time
@@ -0,0 +1,57 @@
+#include "timestep.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+FixedTimestep createFixedTimestep(const double ticksPerSecond, const unsigned int maxTicksPerFrame)
+{
+	FixedTimestep timestep;
+	timestep.tickSeconds = 1.0 / ticksPerSecond;
+	timestep.accumulator = 0.0;
+	timestep.maxTicksPerFrame = maxTicksPerFrame;
+	return timestep;
+}
+
+void advanceFixedTimestep(FixedTimestep &timestep, const double frameSeconds)
+{
+	// Drop the time we wouldn't be able to simulate this frame anyway
+	timestep.accumulator = std::min(timestep.accumulator + frameSeconds, timestep.tickSeconds * timestep.maxTicksPerFrame);
+}
+
+bool consumeTick(FixedTimestep &timestep)
+{
+	if(timestep.accumulator >= timestep.tickSeconds)
+	{
+		timestep.accumulator -= timestep.tickSeconds;
+		return true;
+	}
+	return false;
+}
+
+float getInterpolationAlpha(const FixedTimestep &timestep)
+{
+	return (float) std::min(timestep.accumulator / timestep.tickSeconds, 1.0);
+}
+
+// Time point at which the previous frame was allowed to start
+static std::chrono::steady_clock::time_point _nextFrameTimePoint = std::chrono::steady_clock::now();
+
+void limitFrameRate(const double framesPerSecond)
+{
+	if(framesPerSecond <= 0.0) return;
+
+	const std::chrono::steady_clock::duration frameDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / framesPerSecond));
+	const std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+
+	// If we are ahead of schedule, wait for the next frame. If we have fallen behind, don't try to catch up.
+	if(currentTime < _nextFrameTimePoint)
+	{
+		std::this_thread::sleep_until(_nextFrameTimePoint);
+		_nextFrameTimePoint += frameDuration;
+	}
+	else
+	{
+		_nextFrameTimePoint = currentTime + frameDuration;
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// Fixed-rate simulation clock. Frame time is accumulated and consumed in whole simulation ticks,
+// and the remainder is used to interpolate between the last two simulated states when rendering.
+struct FixedTimestep
+{
+	double tickSeconds; // Length of one simulation tick
+	double accumulator; // Frame time not yet consumed by simulation ticks
+	unsigned int maxTicksPerFrame; // Upper bound on ticks per frame, so a slow frame can't stall the simulation
+};
+
+// Creates a fixed timestep running at 'ticksPerSecond'
+FixedTimestep createFixedTimestep(const double ticksPerSecond, const unsigned int maxTicksPerFrame = 8);
+
+// Adds the elapsed frame time to the accumulator
+void advanceFixedTimestep(FixedTimestep &timestep, const double frameSeconds);
+
+// Returns true (and consumes one tick) while there is at least one whole tick left in the accumulator
+bool consumeTick(FixedTimestep &timestep);
+
+// Returns how far we are between the previous and the current simulation tick, in [0, 1]
+float getInterpolationAlpha(const FixedTimestep &timestep);
+
+// Sleeps so that frames are presented at most 'framesPerSecond' times per second (0 disables the limit)
+void limitFrameRate(const double framesPerSecond);
@@ -0,0 +1,139 @@
+// Benchmark for the clustered lights: builds the cluster grid for growing numbers of point lights, and shades a
+// grid of fragments like simple.frag does, once with the lights of each fragment's cluster and once with every
+// light. Also checks that both give the same result, i.e. that no cluster misses a light that reaches it.
+//     lightingBenchmark [threads]
+
+#include "jobSystem.hpp"
+#include "lightClusters.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Fragments across and up (a quarter of 640 x 360), the number of times each grid is built, and the light radius
+#define FRAGMENTS_X 160
+#define FRAGMENTS_Y 90
+#define BUILD_COUNT 20
+#define LIGHT_RADIUS 4.0f
+
+#define FOV_Y 1.0f
+#define ASPECT (16.0f / 9.0f)
+#define NEAR_PLANE 1.0f
+#define FAR_PLANE 100.0f
+
+// Returns a random float in [0, 1)
+static float randomFloat()
+{
+	return rand() / (RAND_MAX + 1.0f);
+}
+
+// A fragment: normalized window position, view space depth, and world space position and normal
+struct Fragment
+{
+	float x, y, depth;
+	glm::vec3 position, normal;
+};
+
+// Diffuse light from one point light (shadePointLight() in simple.frag)
+static inline glm::vec3 shadePointLight(const PointLight &light, const glm::vec3 &position, const glm::vec3 &normal)
+{
+	const glm::vec3 toLight = glm::vec3(light.positionRadius) - position;
+	const float distance = glm::length(toLight);
+	const float ratio = distance / light.positionRadius.w;
+	const float falloff = glm::clamp(1.0f - ratio * ratio * ratio * ratio, 0.0f, 1.0f);
+	const float brightness = glm::clamp(glm::dot(normal, toLight) / distance, 0.0f, 1.0f);
+	return falloff * falloff * brightness * glm::vec3(light.color);
+}
+
+int main(int argc, char *argv[])
+{
+	const unsigned int threadCount = argc > 1 ? atoi(argv[1]) : 0;
+	initJobSystem(threadCount > 0 ? threadCount - 1 : 0);
+
+	// The camera is at the origin looking down -z (the view matrix is the identity). Every fragment is on a surface
+	// facing the camera at a random depth.
+	const glm::mat4 viewMatrix(1.0f);
+	LightClusterGrid grid = createLightClusterGrid(FOV_Y, ASPECT, NEAR_PLANE, FAR_PLANE);
+	std::vector<Fragment> fragments(FRAGMENTS_X * FRAGMENTS_Y);
+	for(unsigned int i = 0; i < fragments.size(); i++)
+	{
+		Fragment &fragment = fragments[i];
+		fragment.x = ((i % FRAGMENTS_X) + 0.5f) / FRAGMENTS_X;
+		fragment.y = ((i / FRAGMENTS_X) + 0.5f) / FRAGMENTS_Y;
+		fragment.depth = NEAR_PLANE + randomFloat() * (FAR_PLANE - NEAR_PLANE);
+		fragment.position = glm::vec3((fragment.x * 2.0f - 1.0f) * grid.tanHalfFovX * fragment.depth,
+		                              (fragment.y * 2.0f - 1.0f) * grid.tanHalfFovY * fragment.depth, -fragment.depth);
+		fragment.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+	}
+	std::vector<glm::vec3> clusteredColors(fragments.size()), allColors(fragments.size());
+
+	printf("%u fragments, %u clusters, %u threads\n", (unsigned int) fragments.size(), LIGHT_CLUSTER_COUNT, getJobThreadCount());
+	printf("%8s %12s %14s %16s %16s %10s %12s\n", "Lights", "Build (ms)", "Lights/frag", "Clustered (ns)", "All lights (ns)", "Speedup", "Max error");
+	for(unsigned int lightCount = 256; lightCount <= 16384; lightCount *= 4)
+	{
+		// Lights spread through a box around the view frustum
+		std::vector<PointLight> lights(lightCount);
+		for(PointLight &light : lights)
+		{
+			light.positionRadius = glm::vec4((randomFloat() - 0.5f) * 120.0f, (randomFloat() - 0.5f) * 70.0f, -randomFloat() * FAR_PLANE, LIGHT_RADIUS);
+			light.color = glm::vec4(randomFloat(), randomFloat(), randomFloat(), 0.0f);
+		}
+
+		// Cluster grid
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		for(int build = 0; build < BUILD_COUNT; build++)
+		{
+			buildLightClusters(grid, lights.data(), lightCount, viewMatrix);
+		}
+		const double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() / BUILD_COUNT;
+
+		// Shade with the lights of each fragment's cluster
+		unsigned long long clusteredLights = 0;
+		startTime = std::chrono::steady_clock::now();
+		for(unsigned int i = 0; i < fragments.size(); i++)
+		{
+			const Fragment &fragment = fragments[i];
+			const glm::uvec2 cluster = grid.clusters[getLightClusterIndex(grid, fragment.x, fragment.y, fragment.depth)];
+			glm::vec3 color(0.0f);
+			for(unsigned int j = 0; j < cluster.y; j++)
+			{
+				color += shadePointLight(lights[grid.lightIndices[cluster.x + j]], fragment.position, fragment.normal);
+			}
+			clusteredColors[i] = color;
+			clusteredLights += cluster.y;
+		}
+		const double clusteredSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		// Shade with every light
+		startTime = std::chrono::steady_clock::now();
+		for(unsigned int i = 0; i < fragments.size(); i++)
+		{
+			const Fragment &fragment = fragments[i];
+			glm::vec3 color(0.0f);
+			for(unsigned int j = 0; j < lightCount; j++)
+			{
+				color += shadePointLight(lights[j], fragment.position, fragment.normal);
+			}
+			allColors[i] = color;
+		}
+		const double allSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		float maxError = 0.0f;
+		for(unsigned int i = 0; i < fragments.size(); i++)
+		{
+			const glm::vec3 difference = glm::abs(clusteredColors[i] - allColors[i]);
+			maxError = std::max(maxError, std::max(difference.x, std::max(difference.y, difference.z)));
+		}
+
+		printf("%8u %12.3f %14.1f %16.1f %16.1f %9.1fx %12g\n", lightCount, buildSeconds * 1000.0, (double) clusteredLights / fragments.size(),
+			clusteredSeconds * 1e9 / fragments.size(), allSeconds * 1e9 / fragments.size(), allSeconds / clusteredSeconds, maxError);
+	}
+
+	shutdownJobSystem();
+	return 0;
+}
@@ -0,0 +1,90 @@
+// Microbenchmark for the orbit simulation: 100k bodies advanced and evaluated every tick, compared with
+// accumulating glm::rotate() into the matrices like the scene used to, and how far that drifts
+
+#include "orbitSimulation.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define BODY_COUNT 100000
+#define TICK_COUNT 3600
+#define TICK_SECONDS (1.0f / 60.0f)
+
+// Returns a random float in [0, 1)
+static float randomFloat()
+{
+	return rand() / (RAND_MAX + 1.0f);
+}
+
+// Returns the largest absolute difference between the elements of two matrices
+static float matrixDifference(const glm::mat4 &a, const glm::mat4 &b)
+{
+	float difference = 0.0f;
+	for(int column = 0; column < 4; column++)
+	{
+		for(int row = 0; row < 4; row++)
+		{
+			difference = std::max(difference, fabsf(a[column][row] - b[column][row]));
+		}
+	}
+	return difference;
+}
+
+int main()
+{
+	// Bodies in a belt around the origin
+	OrbitSimulation simulation = createOrbitSimulation();
+	std::vector<glm::vec3> axes(BODY_COUNT);
+	std::vector<float> speeds(BODY_COUNT);
+	std::vector<glm::mat4> accumulated(BODY_COUNT);
+	for(unsigned int i = 0; i < BODY_COUNT; i++)
+	{
+		axes[i] = glm::normalize(glm::vec3((randomFloat() - 0.5f) * 0.1f, (randomFloat() - 0.5f) * 0.1f, 1.0f));
+		speeds[i] = 2.0f * (float) PI * (0.05f + randomFloat() * 0.5f);
+		accumulated[i] = glm::translate(glm::vec3(35.0f + randomFloat() * 10.0f, 0.0f, 0.0f)) * glm::scale(glm::vec3(0.1f));
+		addOrbitBody(simulation, axes[i], speeds[i], accumulated[i]);
+	}
+	std::vector<glm::mat4> matrices(BODY_COUNT);
+
+	// Analytic orbits: advance the angles and rebuild the matrices every tick
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for(int tick = 0; tick < TICK_COUNT; tick++)
+	{
+		advanceOrbits(simulation, 0, BODY_COUNT, TICK_SECONDS);
+		computeOrbitMatrices(simulation, 0, BODY_COUNT, 0.0f, &matrices[0]);
+	}
+	const double orbitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	// Accumulated rotations
+	startTime = std::chrono::steady_clock::now();
+	for(int tick = 0; tick < TICK_COUNT; tick++)
+	{
+		for(unsigned int i = 0; i < BODY_COUNT; i++)
+		{
+			accumulated[i] = glm::rotate(speeds[i] * TICK_SECONDS, axes[i]) * accumulated[i];
+		}
+	}
+	const double accumulatedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	// Compare both against the exact matrix at the final time (computed in double precision)
+	float orbitError = 0.0f, accumulatedError = 0.0f;
+	for(unsigned int i = 0; i < BODY_COUNT; i++)
+	{
+		const double angle = fmod((double) speeds[i] * TICK_SECONDS * TICK_COUNT, 2.0 * PI);
+		const glm::dmat4 exact = glm::rotate(angle, glm::dvec3(axes[i])) * glm::dmat4(simulation.baseMatrices[i]);
+		orbitError = std::max(orbitError, matrixDifference(matrices[i], glm::mat4(exact)));
+		accumulatedError = std::max(accumulatedError, matrixDifference(accumulated[i], glm::mat4(exact)));
+	}
+
+	printf("%d bodies, %d ticks\n", BODY_COUNT, TICK_COUNT);
+	printf("Orbit simulation:      %8.3f ms per tick, max error %g\n", orbitSeconds * 1000.0 / TICK_COUNT, orbitError);
+	printf("Accumulated rotations: %8.3f ms per tick, max error %g\n", accumulatedSeconds * 1000.0 / TICK_COUNT, accumulatedError);
+	return 0;
+}
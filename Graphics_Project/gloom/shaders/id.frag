@@ -0,0 +1,21 @@
+#version 430 core
+
+layout(location = 0) in vec2 in_position;
+layout(location = 1) flat in uint in_id;
+layout(location = 2) flat in uint in_tileColumns;
+
+layout(location = 0) out uint out_id;
+
+void main()
+{
+    // A mesh made of unit tiles (the board) writes one ID per tile, starting at in_id
+    if(in_tileColumns > 0u)
+    {
+        uvec2 tile = uvec2(max(floor(in_position), vec2(0.0f)));
+        out_id = in_id + tile.y * in_tileColumns + min(tile.x, in_tileColumns - 1u);
+    }
+    else
+    {
+        out_id = in_id;
+    }
+}
@@ -0,0 +1,33 @@
+#version 430 core
+
+layout(location = 0) in vec3 in_vertexPosition;
+
+layout(location = 0) out vec2 out_position;
+layout(location = 1) flat out uint out_id;
+layout(location = 2) flat out uint out_tileColumns;
+
+// Per-instance data, like in simple.vert
+struct Instance
+{
+	mat4 transformationMatrix;
+	uint selected;
+	uint pickId;
+	uint pickColumns;
+	uint material;
+};
+
+layout(std430, binding = 0) readonly buffer Instances
+{
+	Instance instances[];
+};
+
+uniform layout(location = 0) uint u_firstInstance;
+
+void main()
+{
+	Instance instance = instances[u_firstInstance + gl_InstanceID];
+    gl_Position = instance.transformationMatrix * vec4(in_vertexPosition, 1.0f);
+	out_position = in_vertexPosition.xy;
+	out_id = instance.pickId;
+	out_tileColumns = instance.pickColumns;
+}
@@ -0,0 +1,6 @@
+#version 430 core
+
+// The shadow pass only writes depth
+void main()
+{
+}
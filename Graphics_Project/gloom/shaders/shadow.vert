@@ -0,0 +1,27 @@
+#version 430 core
+
+layout(location = 0) in vec3 in_vertexPosition;
+
+// Per-instance data, like in simple.vert. For the shadow pass the matrix is the light's view-projection times the
+// model matrix (see shadowCascades.hpp).
+struct Instance
+{
+	mat4 transformationMatrix;
+	uint selected;
+	uint pickId;
+	uint pickColumns;
+	uint material;
+};
+
+layout(std430, binding = 0) readonly buffer Instances
+{
+	Instance instances[];
+};
+
+uniform layout(location = 0) uint u_firstInstance;
+
+void main()
+{
+	Instance instance = instances[u_firstInstance + gl_InstanceID];
+    gl_Position = instance.transformationMatrix * vec4(in_vertexPosition, 1.0f);
+}
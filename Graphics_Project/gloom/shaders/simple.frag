@@ -1,13 +1,49 @@
 #version 430 core
 
 layout(location = 0) in vec4 in_color;
+layout(location = 1) flat in uint in_selected;
+layout(location = 2) in vec3 in_textureCoordinates;
+layout(location = 3) in vec4 in_clipPosition;
 
 layout(location = 0) out vec4 out_fragColor;
 
-uniform layout(location = 1) bool u_selected;
+// Material textures, the layer is the instance's material (see material.hpp)
+layout(binding = 0) uniform sampler2DArray u_materials;
+
+// Shadow maps of the cascades (layer i is cascade i, see shadowCascades.hpp), the camera's inverse view-projection,
+// the view depth where every cascade ends and the world to shadow map matrices of the cascades
+const int shadowCascadeCount = 3;
+layout(binding = 1) uniform sampler2DArrayShadow u_shadowMaps;
+uniform layout(location = 1) mat4 u_inverseViewProjection;
+uniform layout(location = 2) vec4 u_cascadeSplits;
+uniform layout(location = 3) mat4 u_cascadeMatrices[shadowCascadeCount];
+
+// Returns how much of the fragment is lit by the light (0 in shadow, 1 outside the shadowed range)
+float getLightVisibility()
+{
+	// The view depth is the clip w, and the world position is the interpolated clip position taken back to world space
+	float depth = in_clipPosition.w;
+	int cascade = depth < u_cascadeSplits.x ? 0 : (depth < u_cascadeSplits.y ? 1 : (depth < u_cascadeSplits.z ? 2 : shadowCascadeCount));
+	if(cascade == shadowCascadeCount) return 1.0;
+
+	vec4 world = u_inverseViewProjection * in_clipPosition;
+	vec3 shadowPosition = (u_cascadeMatrices[cascade] * vec4(world.xyz / world.w, 1.0)).xyz * 0.5 + 0.5;
+
+	// 2x2 percentage-closer filtering by the hardware, averaged over 4 taps
+	vec2 texelSize = 1.0 / vec2(textureSize(u_shadowMaps, 0).xy);
+	float visibility = 0.0;
+	for(int i = 0; i < 4; i++)
+	{
+		vec2 offset = (vec2(i & 1, i >> 1) - 0.5) * texelSize;
+		visibility += texture(u_shadowMaps, vec4(shadowPosition.xy + offset, float(cascade), shadowPosition.z));
+	}
+	return visibility * 0.25;
+}
 
 void main()
 {
     // Calculate out color using brightness
-    out_fragColor = vec4(mix(in_color.rgb, vec3(0.75, 0.75, 0.25), u_selected), 1.0f);
-}
\ No newline at end of file
+    vec3 color = in_color.rgb * texture(u_materials, in_textureCoordinates).rgb;
+    color *= mix(0.5, 1.0, getLightVisibility());
+    out_fragColor = vec4(mix(color, vec3(0.75, 0.75, 0.25), in_selected != 0u), 1.0f);
+}
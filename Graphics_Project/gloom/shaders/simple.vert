@@ -4,11 +4,35 @@ layout(location = 0) in vec3 in_vertexPosition;
 layout(location = 1) in vec4 in_vertexColor;
 
 layout(location = 0) out vec4 out_color;
+layout(location = 1) flat out uint out_selected;
+layout(location = 2) out vec3 out_textureCoordinates;
+layout(location = 3) out vec4 out_clipPosition;
 
-uniform layout(location = 0) mat4 u_transformationMatrix;
+// Per-instance data, written to the upload ring every frame in draw list order (GpuInstance in glRenderBackend.cpp)
+struct Instance
+{
+	mat4 transformationMatrix;
+	uint selected;
+	uint pickId;
+	uint pickColumns;
+	uint material;
+};
+
+layout(std430, binding = 0) readonly buffer Instances
+{
+	Instance instances[];
+};
+
+uniform layout(location = 0) uint u_firstInstance;
 
 void main()
 {
-    gl_Position = u_transformationMatrix * vec4(in_vertexPosition, 1.0f);
+	Instance instance = instances[u_firstInstance + gl_InstanceID];
+    gl_Position = instance.transformationMatrix * vec4(in_vertexPosition, 1.0f);
+	out_clipPosition = gl_Position;
 	out_color = in_vertexColor;
+	out_selected = instance.selected;
+
+	// Textures are mapped onto the xy-plane of the model (one repeat per unit, a board tile or a shape)
+	out_textureCoordinates = vec3(in_vertexPosition.xy, float(instance.material));
 }
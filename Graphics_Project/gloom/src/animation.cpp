@@ -0,0 +1,157 @@
+#include "animation.hpp"
+
+#include <algorithm>
+
+// Easing polynomial coefficients (a, b, c) for e(t) = a*t + b*t^2 + c*t^3
+static const float easingCoefficients[EASING_COUNT][3] =
+{
+	{ 1.0f,  0.0f,  0.0f }, // EASE_LINEAR
+	{ 0.0f,  1.0f,  0.0f }, // EASE_IN_QUAD
+	{ 2.0f, -1.0f,  0.0f }, // EASE_OUT_QUAD
+	{ 0.0f,  3.0f, -2.0f }, // EASE_IN_OUT
+	{ 0.0f,  0.0f,  1.0f }, // EASE_IN_CUBIC
+	{ 3.0f, -3.0f,  1.0f }  // EASE_OUT_CUBIC
+};
+
+// Resizes every array in the pool
+static void resizeTweenPool(TweenPool &pool, const unsigned int size)
+{
+	pool.nodes.resize(size);
+	pool.fromX.resize(size); pool.fromY.resize(size);
+	pool.toX.resize(size); pool.toY.resize(size);
+	pool.time.resize(size);
+	pool.inverseDuration.resize(size);
+	pool.easeA.resize(size); pool.easeB.resize(size); pool.easeC.resize(size);
+	pool.x.resize(size); pool.y.resize(size);
+	pool.previousX.resize(size); pool.previousY.resize(size);
+	pool.finished.resize(size);
+}
+
+// Moves the tween in slot 'src' into slot 'dst'
+static void moveTween(TweenPool &pool, const unsigned int dst, const unsigned int src)
+{
+	pool.nodes[dst] = pool.nodes[src];
+	pool.fromX[dst] = pool.fromX[src]; pool.fromY[dst] = pool.fromY[src];
+	pool.toX[dst] = pool.toX[src]; pool.toY[dst] = pool.toY[src];
+	pool.time[dst] = pool.time[src];
+	pool.inverseDuration[dst] = pool.inverseDuration[src];
+	pool.easeA[dst] = pool.easeA[src]; pool.easeB[dst] = pool.easeB[src]; pool.easeC[dst] = pool.easeC[src];
+	pool.x[dst] = pool.x[src]; pool.y[dst] = pool.y[src];
+	pool.previousX[dst] = pool.previousX[src]; pool.previousY[dst] = pool.previousY[src];
+	pool.finished[dst] = pool.finished[src];
+}
+
+// Returns the slot of the tween moving 'node', or -1 if there is none
+static int findTween(const TweenPool &pool, const SceneNode *node)
+{
+	for(unsigned int i = 0; i < pool.count; i++)
+	{
+		if(pool.nodes[i] == node) return i;
+	}
+	return -1;
+}
+
+TweenPool createTweenPool(const unsigned int capacity)
+{
+	TweenPool pool;
+	pool.count = 0;
+	resizeTweenPool(pool, capacity);
+	return pool;
+}
+
+void addTween(TweenPool &pool, SceneNode *node, const float fromX, const float fromY, const float toX, const float toY,
+              const float duration, const Easing easing, const float delay)
+{
+	// Replace the current tween of this node, continuing from its current position
+	float startX = fromX, startY = fromY;
+	int i = findTween(pool, node);
+	if(i >= 0)
+	{
+		startX = pool.x[i];
+		startY = pool.y[i];
+	}
+	else
+	{
+		if(pool.count == pool.nodes.size())
+		{
+			resizeTweenPool(pool, std::max(16u, pool.count * 2));
+		}
+		i = pool.count++;
+		pool.previousX[i] = startX;
+		pool.previousY[i] = startY;
+	}
+
+	pool.nodes[i] = node;
+	pool.fromX[i] = startX; pool.fromY[i] = startY;
+	pool.toX[i] = toX; pool.toY[i] = toY;
+	pool.time[i] = -delay;
+	pool.inverseDuration[i] = 1.0f / std::max(duration, 1e-6f);
+	pool.easeA[i] = easingCoefficients[easing][0];
+	pool.easeB[i] = easingCoefficients[easing][1];
+	pool.easeC[i] = easingCoefficients[easing][2];
+	pool.x[i] = startX; pool.y[i] = startY;
+	pool.finished[i] = 0;
+}
+
+bool isTweening(const TweenPool &pool, const SceneNode *node)
+{
+	return findTween(pool, node) >= 0;
+}
+
+void updateTweens(TweenPool &pool, const float dt)
+{
+	// Remove the tweens that finished at the previous tick. They have been rendered at their end position
+	// at least once by now, so we write the final transformation and stop touching the node.
+	for(unsigned int i = 0; i < pool.count;)
+	{
+		if(pool.finished[i])
+		{
+			SceneNode *node = pool.nodes[i];
+			node->x = pool.toX[i];
+			node->y = pool.toY[i];
+			initTransformationMatrix(node);
+			moveTween(pool, i, --pool.count);
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	// Advance every active tween. The loop body is branch-free over plain float arrays, so it vectorizes.
+	const unsigned int count = pool.count;
+	float *time = pool.time.data();
+	const float *inverseDuration = pool.inverseDuration.data();
+	const float *easeA = pool.easeA.data(), *easeB = pool.easeB.data(), *easeC = pool.easeC.data();
+	const float *fromX = pool.fromX.data(), *fromY = pool.fromY.data();
+	const float *toX = pool.toX.data(), *toY = pool.toY.data();
+	float *x = pool.x.data(), *y = pool.y.data();
+	float *previousX = pool.previousX.data(), *previousY = pool.previousY.data();
+	unsigned char *finished = pool.finished.data();
+	for(unsigned int i = 0; i < count; i++)
+	{
+		previousX[i] = x[i];
+		previousY[i] = y[i];
+
+		time[i] += dt;
+		const float t = std::min(std::max(time[i] * inverseDuration[i], 0.0f), 1.0f);
+		const float e = t * (easeA[i] + t * (easeB[i] + t * easeC[i]));
+
+		x[i] = fromX[i] + (toX[i] - fromX[i]) * e;
+		y[i] = fromY[i] + (toY[i] - fromY[i]) * e;
+		finished[i] = t >= 1.0f;
+	}
+}
+
+void applyTweens(TweenPool &pool, const float alpha)
+{
+	for(unsigned int i = 0; i < pool.count; i++)
+	{
+		SceneNode *node = pool.nodes[i];
+		node->x = pool.previousX[i] + (pool.x[i] - pool.previousX[i]) * alpha;
+		node->y = pool.previousY[i] + (pool.y[i] - pool.previousY[i]) * alpha;
+	}
+
+	// Rebuild the transformation matrices of the moving nodes in one batch
+	initTransformationMatrices(pool.transforms, pool.nodes.data(), pool.count);
+}
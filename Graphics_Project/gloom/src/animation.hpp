@@ -0,0 +1,52 @@
+#pragma once
+
+#include "sceneGraph.hpp"
+
+#include <vector>
+
+// Easing curves. Every curve is a cubic polynomial e(t) = a*t + b*t^2 + c*t^3 with e(0) = 0 and e(1) = 1,
+// which lets updateTweens() evaluate all tweens in one branch-free pass regardless of their curve.
+enum Easing
+{
+	EASE_LINEAR,
+	EASE_IN_QUAD,
+	EASE_OUT_QUAD,
+	EASE_IN_OUT, // Smoothstep
+	EASE_IN_CUBIC,
+	EASE_OUT_CUBIC,
+	EASING_COUNT
+};
+
+// Pool of position tweens stored as a structure of arrays. Finished tweens are removed by moving the last
+// tween into their slot, so the active tweens always occupy the first 'count' elements of every array.
+struct TweenPool
+{
+	unsigned int count; // Number of active tweens
+	std::vector<SceneNode*> nodes; // Node that is moved by the tween
+	std::vector<float> fromX, fromY; // Start position
+	std::vector<float> toX, toY; // End position
+	std::vector<float> time; // Time since the tween started (negative while the tween is delayed)
+	std::vector<float> inverseDuration; // 1 / duration of the tween
+	std::vector<float> easeA, easeB, easeC; // Easing polynomial coefficients
+	std::vector<float> x, y; // Position at the current simulation tick
+	std::vector<float> previousX, previousY; // Position at the previous simulation tick
+	std::vector<unsigned char> finished; // Set when the tween reached its end position
+	TransformBuilder transforms; // Buffers for rebuilding the transformation matrices of the tweened nodes
+};
+
+// Creates an empty tween pool with room for 'capacity' tweens before it has to grow
+TweenPool createTweenPool(const unsigned int capacity);
+
+// Starts moving 'node' from [fromX, fromY] to [toX, toY] after 'delay' seconds.
+// If the node is already being moved, that tween is replaced and the node continues from where it is.
+void addTween(TweenPool &pool, SceneNode *node, const float fromX, const float fromY, const float toX, const float toY,
+              const float duration, const Easing easing, const float delay = 0.0f);
+
+// Returns true if 'node' is moved by one of the tweens in the pool
+bool isTweening(const TweenPool &pool, const SceneNode *node);
+
+// Advances all tweens by one simulation tick and removes the ones that finished at the previous tick
+void updateTweens(TweenPool &pool, const float dt);
+
+// Places every tweened node between its last two simulated positions and updates its transformation matrix
+void applyTweens(TweenPool &pool, const float alpha);
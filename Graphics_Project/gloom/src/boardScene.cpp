@@ -0,0 +1,91 @@
+#include "boardScene.hpp"
+#include "shapes.hpp"
+#include "material.hpp"
+
+#include <cctype>
+#include <string>
+
+// Returns the material of 'shape' (the texture is named after the shape, in lower case)
+static int getShapeMaterial(const Shape shape)
+{
+	std::string name = getShapeName(shape);
+	for(char &c : name)
+	{
+		c = (char) tolower(c);
+	}
+	return getMaterial(name);
+}
+
+void createBoardScene(const BoardState &state, BoardScene &scene)
+{
+	// Create board
+	SceneNode *boardNode = createSceneNode();
+	boardNode->meshID = getBoardMesh(state.startWithBlue);
+	boardNode->materialID = getMaterial("board");
+	boardNode->z = -0.5f; boardNode->x = -4.0f; boardNode->y = -2.5f; // Center node
+	boardNode->rotationX = PI * 0.5f;
+	scene.boardNode = boardNode;
+
+	// Create move marker
+	scene.moveMarkerNode = createSceneNode();
+	scene.moveMarkerNode->meshID = getMoveMarkerMesh();
+	scene.moveMarkerNode->materialID = getMaterial("moveMarker");
+	scene.moveMarkerNode->z = 0.001f;
+	scene.moveMarkerNode->castsShadow = false; // It lies on the board
+	addChild(boardNode, scene.moveMarkerNode);
+
+	// Create shapes at the correct position
+	for(int y = 0; y < BOARD_HEIGHT; y++)
+	{
+		for(int x = 0; x < BOARD_WIDTH; x++)
+		{
+			const Shape shape = getTileShape(state, x, y);
+			scene.tileNodes[y][x] = 0;
+			if(shape != SHAPE_NONE)
+			{
+				// Create shape node
+				SceneNode *shapeNode = createSceneNode();
+				shapeNode->meshID = getShapeMesh(shape);
+				shapeNode->materialID = getShapeMaterial(shape);
+				shapeNode->z = -0.250001f;
+				shapeNode->x = x + 0.5f;
+				shapeNode->y = y + 0.5f;
+				shapeNode->scaleFactor = 0.75f;
+				scene.tileNodes[y][x] = shapeNode;
+
+				// Add child
+				addChild(boardNode, shapeNode);
+			}
+		}
+	}
+
+	// Init transformation matrices
+	initTransformationMatrix(boardNode);
+}
+
+void computeCameraAxes(const float pitch, const float yaw, glm::vec3 &fwd, glm::vec3 &right, glm::vec3 &up)
+{
+	fwd.x = cos(glm::radians(pitch)) * cos(glm::radians(yaw));
+	fwd.y = sin(glm::radians(pitch));
+	fwd.z = cos(glm::radians(pitch)) * sin(glm::radians(yaw));
+	right = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), fwd));
+	up = glm::cross(fwd, right);
+}
+
+glm::mat4 getCameraViewProjectionMatrix(const glm::mat4 &projectionMatrix, const glm::vec3 &cameraPosition, const float pitch, const float yaw)
+{
+	glm::vec3 fwd, right, up;
+	computeCameraAxes(pitch, yaw, fwd, right, up);
+	glm::mat4 eyeSpaceMatrix(
+		right.x, up.x, fwd.x, 0.0f,
+		right.y, up.y, fwd.y, 0.0f,
+		right.z, up.z, fwd.z, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Calcualte our projection matrix
+	glm::mat4 viewProjectionMatrix;
+	viewProjectionMatrix = eyeSpaceMatrix * viewProjectionMatrix;					// mvp = eyeSpaceMatrix
+	viewProjectionMatrix = glm::translate(viewProjectionMatrix, -cameraPosition);	// mvp = eyeSpaceMatrix * centerCameraMatrix
+	viewProjectionMatrix = projectionMatrix * viewProjectionMatrix;					// mvp = projectionMatrix * eyeSpaceMatrix * centerCameraMatrix
+	return viewProjectionMatrix;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "boardState.hpp"
+#include "sceneGraph.hpp"
+
+// Scene nodes of a board. Building the scene only registers meshes, so it works without a GL context
+// (see setMeshRenderBackend()).
+struct BoardScene
+{
+	SceneNode *boardNode; // Root node
+	SceneNode *moveMarkerNode; // The move marker (a yellow quad indicating where we want to move our shape)
+	SceneNode *tileNodes[BOARD_HEIGHT][BOARD_WIDTH]; // Shapes on the board (0 for empty tiles)
+};
+
+// Creates the board, the move marker and the shapes of 'state', and initializes their transformation matrices
+void createBoardScene(const BoardState &state, BoardScene &scene);
+
+// Calculates the camera's forward, right and up vector from its pitch and yaw (in degrees)
+void computeCameraAxes(const float pitch, const float yaw, glm::vec3 &fwd, glm::vec3 &right, glm::vec3 &up);
+
+// Returns the view-projection matrix of a camera at 'cameraPosition' with the given pitch and yaw (in degrees)
+glm::mat4 getCameraViewProjectionMatrix(const glm::mat4 &projectionMatrix, const glm::vec3 &cameraPosition, const float pitch, const float yaw);
@@ -0,0 +1,283 @@
+#include "boardSolver.hpp"
+#include "jobSystem.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+// All tiles of the board
+static const Bitboard boardMask = BOARD_TILE_COUNT == 64 ? ~(Bitboard) 0 : ((Bitboard) 1 << BOARD_TILE_COUNT) - 1;
+
+// Number of subtrees per job thread the frontier is split into, and how deep the split may go
+#define SOLVER_SUBTREES_PER_THREAD 16
+#define SOLVER_MAX_SPLIT_DEPTH 4
+
+// Transposition table entry. The key is stored xor'ed with the data, so an entry that was torn by two threads
+// writing it at the same time doesn't validate, and the table needs no locks (Hyatt and Mann's lockless hashing).
+struct TranspositionEntry
+{
+	std::atomic<uint64_t> keyXorData;
+	std::atomic<uint64_t> data; // Iteration in the high 32 bits, moves from the start (g) in the low 32 bits
+};
+
+// Returns true if 'key' was already reached in this iteration with at most 'g' moves, and otherwise records it
+static bool probeTranspositionTable(TranspositionEntry *table, const uint64_t mask, const uint64_t key, const unsigned int g, const unsigned int iteration)
+{
+	TranspositionEntry &entry = table[key & mask];
+	const uint64_t data = entry.data.load(std::memory_order_relaxed);
+	const uint64_t keyXorData = entry.keyXorData.load(std::memory_order_relaxed);
+	if((keyXorData ^ data) == key && (data >> 32) == iteration && (data & 0xffffffffu) <= g)
+	{
+		return true;
+	}
+
+	const uint64_t newData = ((uint64_t) iteration << 32) | g;
+	entry.keyXorData.store(key ^ newData, std::memory_order_relaxed);
+	entry.data.store(newData, std::memory_order_relaxed);
+	return false;
+}
+
+// A move of 'shape' between two tiles (bit indices), and the change in the estimated move count
+struct SolverMove
+{
+	unsigned char shape, from, to;
+	signed char deltaH;
+};
+
+// Moves a shape between two tiles, without checking what is on them
+static inline void applySolverMove(BoardState &state, const SolverMove &move)
+{
+	const ZobristKeys &keys = getZobristKeys();
+	state.hash ^= keys.tiles[move.from][move.shape] ^ keys.tiles[move.to][move.shape];
+	const Bitboard bits = ((Bitboard) 1 << move.from) | ((Bitboard) 1 << move.to);
+	state.shapes[move.shape] ^= bits;
+	state.occupied ^= bits;
+	state.occupiedColumnMajor ^= ((Bitboard) 1 << ((move.from % BOARD_WIDTH) * BOARD_HEIGHT + move.from / BOARD_WIDTH))
+		| ((Bitboard) 1 << ((move.to % BOARD_WIDTH) * BOARD_HEIGHT + move.to / BOARD_WIDTH));
+}
+
+static inline TileMove toTileMove(const SolverMove &move)
+{
+	TileMove tileMove;
+	tileMove.fromX = move.from % BOARD_WIDTH;
+	tileMove.fromY = move.from / BOARD_WIDTH;
+	tileMove.toX = move.to % BOARD_WIDTH;
+	tileMove.toY = move.to / BOARD_WIDTH;
+	return tileMove;
+}
+
+// Writes the moves from a state with 'g' moves and estimate 'h' that stay within 'bound' to 'moves'.
+// Only misplaced shapes are moved, and moves that put a shape on one of its target tiles come first.
+static void generateSolverMoves(const BoardState &state, const BoardState &target, const int g, const int h, const int bound, std::vector<SolverMove> &moves)
+{
+	moves.clear();
+	const Bitboard empty = ~state.occupied & boardMask;
+	const bool allowSideMoves = g + 1 + h <= bound;
+	for(int pass = 0; pass < (allowSideMoves ? 2 : 1); pass++)
+	{
+		for(int shape = SHAPE_NONE + 1; shape < SHAPE_COUNT; shape++)
+		{
+			const Bitboard destinations = pass == 0 ? empty & target.shapes[shape] : empty & ~target.shapes[shape];
+			if(!destinations) continue;
+
+			for(Bitboard from = state.shapes[shape] & ~target.shapes[shape]; from; from &= from - 1)
+			{
+				for(Bitboard to = destinations; to; to &= to - 1)
+				{
+					SolverMove move;
+					move.shape = (unsigned char) shape;
+					move.from = (unsigned char) bitScanForward(from);
+					move.to = (unsigned char) bitScanForward(to);
+					move.deltaH = pass == 0 ? -1 : 0;
+					moves.push_back(move);
+				}
+			}
+		}
+	}
+}
+
+// State shared by all the jobs of one iteration
+struct SolverIteration
+{
+	const BoardState *target;
+	int bound;
+	unsigned int iteration;
+	TranspositionEntry *table;
+	uint64_t tableMask;
+	std::atomic<bool> found;
+	std::atomic<uint64_t> nodes;
+	std::mutex solutionMutex;
+	std::vector<TileMove> solution;
+};
+
+// State of one depth-first search job
+struct SolverSearch
+{
+	SolverIteration *iteration;
+	std::vector<std::vector<SolverMove> > moveStack; // Move list of every depth, reused between nodes
+	std::vector<TileMove> path; // Moves from the root of the job's subtree
+	uint64_t nodes;
+};
+
+// Depth-first search below 'state', bounded by the iteration's cost bound. Returns true if the target was reached.
+static bool searchSubtree(SolverSearch &search, BoardState &state, const int g, const int h, const unsigned int depth)
+{
+	SolverIteration &iteration = *search.iteration;
+	search.nodes++;
+	if(h == 0) return true;
+	if(iteration.found.load(std::memory_order_relaxed)) return false;
+	if(probeTranspositionTable(iteration.table, iteration.tableMask, state.hash, g, iteration.iteration)) return false;
+
+	if(search.moveStack.size() <= depth) search.moveStack.resize(depth + 1);
+	std::vector<SolverMove> &moves = search.moveStack[depth];
+	generateSolverMoves(state, *iteration.target, g, h, iteration.bound, moves);
+
+	for(unsigned int i = 0; i < moves.size(); i++)
+	{
+		// Take a copy, the move list may be reallocated by deeper levels
+		const SolverMove move = moves[i];
+		applySolverMove(state, move);
+		search.path.push_back(toTileMove(move));
+		if(searchSubtree(search, state, g + 1, h + move.deltaH, depth + 1)) return true;
+
+		search.path.pop_back();
+		applySolverMove(state, move);
+	}
+	return false;
+}
+
+// Root of a subtree in the frontier
+struct FrontierNode
+{
+	BoardState state;
+	int h;
+	std::vector<TileMove> path;
+};
+
+int estimateMoveCount(const BoardState &state, const BoardState &target)
+{
+	int h = 0;
+	for(int shape = SHAPE_NONE + 1; shape < SHAPE_COUNT; shape++)
+	{
+		h += popCount(state.shapes[shape] & ~target.shapes[shape]);
+	}
+	return h;
+}
+
+bool haveSameShapes(const BoardState &state, const BoardState &target)
+{
+	for(int shape = SHAPE_NONE + 1; shape < SHAPE_COUNT; shape++)
+	{
+		if(countShapes(state, (Shape) shape) != countShapes(target, (Shape) shape)) return false;
+	}
+	return true;
+}
+
+bool solveBoard(const BoardState &start, const BoardState &target, std::vector<TileMove> &moves, SolverStats *stats, const unsigned int maxMoves, const unsigned int tableBits)
+{
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	moves.clear();
+
+	SolverStats localStats = {};
+	SolverStats &result = stats ? *stats : localStats;
+	result = localStats;
+
+	// Both boards need the same number of every shape
+	if(!haveSameShapes(start, target)) return false;
+
+	// Transposition table
+	const uint64_t tableSize = (uint64_t) 1 << tableBits;
+	std::vector<TranspositionEntry> table(tableSize);
+	for(TranspositionEntry &entry : table)
+	{
+		entry.keyXorData.store(0, std::memory_order_relaxed);
+		entry.data.store(0, std::memory_order_relaxed);
+	}
+	result.tableBytes = tableSize * sizeof(TranspositionEntry);
+
+	FrontierNode root;
+	root.state = start;
+	root.h = estimateMoveCount(start, target);
+
+	bool solved = root.h == 0;
+	std::vector<SolverMove> rootMoves;
+	for(int bound = root.h; !solved && bound <= (int) maxMoves; bound++)
+	{
+		SolverIteration iteration;
+		iteration.target = &target;
+		iteration.bound = bound;
+		iteration.iteration = ++result.iterations;
+		iteration.table = &table[0];
+		iteration.tableMask = tableSize - 1;
+		iteration.found.store(false);
+		iteration.nodes.store(0);
+
+		// Expand the top of the tree breadth-first until there are enough subtrees to keep every thread busy
+		std::vector<FrontierNode> frontier(1, root);
+		const unsigned int frontierTarget = getJobThreadCount() * SOLVER_SUBTREES_PER_THREAD;
+		for(int g = 0; g < SOLVER_MAX_SPLIT_DEPTH && !solved && !frontier.empty() && frontier.size() < frontierTarget; g++)
+		{
+			std::vector<FrontierNode> next;
+			for(const FrontierNode &node : frontier)
+			{
+				result.nodes++;
+				generateSolverMoves(node.state, target, g, node.h, bound, rootMoves);
+				for(const SolverMove &move : rootMoves)
+				{
+					FrontierNode child = node;
+					applySolverMove(child.state, move);
+					child.h += move.deltaH;
+					child.path.push_back(toTileMove(move));
+					if(child.h == 0)
+					{
+						moves = child.path;
+						solved = true;
+						break;
+					}
+					next.push_back(child);
+				}
+				if(solved) break;
+			}
+			frontier.swap(next);
+		}
+		if(solved) break;
+		if(frontier.empty()) continue;
+		result.frontierSize = frontier.size();
+
+		// Search the subtrees in parallel
+		const int frontierDepth = (int) frontier[0].path.size();
+		parallelFor(frontier.size(), 1, [&](unsigned int begin, unsigned int end)
+		{
+			SolverSearch search;
+			search.iteration = &iteration;
+			search.nodes = 0;
+			for(unsigned int i = begin; i < end && !iteration.found.load(std::memory_order_relaxed); i++)
+			{
+				BoardState state = frontier[i].state;
+				search.path.clear();
+				if(searchSubtree(search, state, frontierDepth, frontier[i].h, 0))
+				{
+					std::lock_guard<std::mutex> lock(iteration.solutionMutex);
+					if(!iteration.found.load())
+					{
+						iteration.solution = frontier[i].path;
+						iteration.solution.insert(iteration.solution.end(), search.path.begin(), search.path.end());
+						iteration.found.store(true);
+					}
+				}
+			}
+			iteration.nodes.fetch_add(search.nodes, std::memory_order_relaxed);
+		});
+
+		result.nodes += iteration.nodes.load();
+		if(iteration.found.load())
+		{
+			moves.swap(iteration.solution);
+			solved = true;
+		}
+	}
+
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return solved;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "boardState.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+// Parallel IDA* search for the shortest sequence of moves that turns one board into another.
+// A move takes a shape and puts it on any empty tile, like selectShape() does.
+// Every iteration splits the top of the search tree into a frontier of subtrees that are searched as jobs on the
+// work-stealing job system (see jobSystem.hpp), so initJobSystem() must have been called.
+// Threads share a lock-free transposition table keyed by the Zobrist hashes of the board states (BoardState::hash).
+
+// Default transposition table size (2^bits entries of 16 bytes)
+#define SOLVER_DEFAULT_TABLE_BITS 22
+
+// Search statistics
+struct SolverStats
+{
+	uint64_t nodes; // Board states expanded
+	double seconds; // Wall clock time
+	unsigned int iterations; // IDA* iterations (cost bounds tried)
+	unsigned int frontierSize; // Subtrees in the last iteration
+	uint64_t tableBytes; // Memory used by the transposition table
+};
+
+// Returns a lower bound on the number of moves needed to turn 'state' into 'target' (the number of misplaced shapes)
+int estimateMoveCount(const BoardState &state, const BoardState &target);
+
+// Returns true if both boards have the same number of every shape, which a solution needs
+bool haveSameShapes(const BoardState &state, const BoardState &target);
+
+// Finds the shortest sequence of moves from 'start' to 'target' and writes it to 'moves'.
+// Returns false if the boards don't have the same shapes, or if no solution was found within 'maxMoves' moves.
+bool solveBoard(const BoardState &start, const BoardState &target, std::vector<TileMove> &moves, SolverStats *stats = 0,
+	const unsigned int maxMoves = 2 * BOARD_TILE_COUNT, const unsigned int tableBits = SOLVER_DEFAULT_TABLE_BITS);
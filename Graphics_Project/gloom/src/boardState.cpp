@@ -0,0 +1,308 @@
+#include "boardState.hpp"
+
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+int popCount(Bitboard bits)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(bits);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	return (int) __popcnt64(bits);
+#else
+	bits = bits - ((bits >> 1) & 0x5555555555555555ull);
+	bits = (bits & 0x3333333333333333ull) + ((bits >> 2) & 0x3333333333333333ull);
+	bits = (bits + (bits >> 4)) & 0x0f0f0f0f0f0f0f0full;
+	return (int) ((bits * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+int bitScanForward(Bitboard bits)
+{
+	// The bits below the lowest set bit, counted
+	return popCount((bits & (0 - bits)) - 1);
+}
+
+int bitScanReverse(Bitboard bits)
+{
+	// Smear the highest set bit into all lower bits and count them
+	bits |= bits >> 1;
+	bits |= bits >> 2;
+	bits |= bits >> 4;
+	bits |= bits >> 8;
+	bits |= bits >> 16;
+	bits |= bits >> 32;
+	return popCount(bits) - 1;
+}
+
+// Bit of tile [x, y] in row-major and column-major order
+static inline Bitboard rowMajorBit(const int x, const int y) { return (Bitboard) 1 << (y * BOARD_WIDTH + x); }
+static inline Bitboard columnMajorBit(const int x, const int y) { return (Bitboard) 1 << (x * BOARD_HEIGHT + y); }
+
+// Fills the key table using splitmix64 with a fixed seed
+static ZobristKeys createZobristKeys()
+{
+	ZobristKeys keys;
+	uint64_t seed = 0x9e3779b97f4a7c15ull;
+	uint64_t *key = &keys.tiles[0][0];
+	for(unsigned int i = 0; i < BOARD_TILE_COUNT * SHAPE_COUNT + 1; i++)
+	{
+		uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		if(i < BOARD_TILE_COUNT * SHAPE_COUNT) key[i] = i % SHAPE_COUNT == SHAPE_NONE ? 0 : z ^ (z >> 31);
+		else keys.startWithBlue = z ^ (z >> 31);
+	}
+	return keys;
+}
+
+const ZobristKeys &getZobristKeys()
+{
+	static const ZobristKeys keys = createZobristKeys();
+	return keys;
+}
+
+uint64_t computeBoardHash(const BoardState &state)
+{
+	const ZobristKeys &keys = getZobristKeys();
+	uint64_t hash = state.startWithBlue ? keys.startWithBlue : 0;
+	for(int shape = SHAPE_NONE + 1; shape < SHAPE_COUNT; shape++)
+	{
+		for(Bitboard bits = state.shapes[shape]; bits; bits &= bits - 1)
+		{
+			hash ^= keys.tiles[bitScanForward(bits)][shape];
+		}
+	}
+	return hash;
+}
+
+void clearBoardState(BoardState &state, const bool startWithBlue)
+{
+	memset(state.shapes, 0, sizeof(state.shapes));
+	state.occupied = 0;
+	state.occupiedColumnMajor = 0;
+	state.startWithBlue = startWithBlue;
+	state.hash = startWithBlue ? getZobristKeys().startWithBlue : 0;
+}
+
+Shape getTileShape(const BoardState &state, const int x, const int y)
+{
+	const Bitboard bit = rowMajorBit(x, y);
+	if(!(state.occupied & bit)) return SHAPE_NONE;
+	for(int shape = SHAPE_NONE + 1; shape < SHAPE_COUNT; shape++)
+	{
+		if(state.shapes[shape] & bit) return (Shape) shape;
+	}
+	return SHAPE_NONE;
+}
+
+bool isTileOccupied(const BoardState &state, const int x, const int y)
+{
+	return (state.occupied & rowMajorBit(x, y)) != 0;
+}
+
+void setTileShape(BoardState &state, const int x, const int y, const Shape shape)
+{
+	// Remove whatever is on the tile
+	const ZobristKeys &keys = getZobristKeys();
+	const Bitboard bit = rowMajorBit(x, y);
+	state.hash ^= keys.tiles[y * BOARD_WIDTH + x][getTileShape(state, x, y)];
+	for(int s = SHAPE_NONE + 1; s < SHAPE_COUNT; s++)
+	{
+		state.shapes[s] &= ~bit;
+	}
+	state.occupied &= ~bit;
+	state.occupiedColumnMajor &= ~columnMajorBit(x, y);
+
+	// Place the new shape
+	if(shape != SHAPE_NONE)
+	{
+		state.shapes[shape] |= bit;
+		state.occupied |= bit;
+		state.occupiedColumnMajor |= columnMajorBit(x, y);
+		state.hash ^= keys.tiles[y * BOARD_WIDTH + x][shape];
+	}
+}
+
+void moveTileShape(BoardState &state, const int fromX, const int fromY, const int toX, const int toY)
+{
+	const Shape shape = getTileShape(state, fromX, fromY);
+	setTileShape(state, fromX, fromY, getTileShape(state, toX, toY));
+	setTileShape(state, toX, toY, shape);
+}
+
+int countShapes(const BoardState &state, const Shape shape)
+{
+	if(shape == SHAPE_NONE) return BOARD_TILE_COUNT - popCount(state.occupied);
+	return popCount(state.shapes[shape]);
+}
+
+bool isSameBoardState(const BoardState &a, const BoardState &b)
+{
+	return a.hash == b.hash && a.startWithBlue == b.startWithBlue && memcmp(a.shapes, b.shapes, sizeof(a.shapes)) == 0;
+}
+
+bool findNextOccupiedTile(const BoardState &state, int &x, int &y, const int dx, const int dy)
+{
+	// Pick the traversal order and the index of the current tile in that order
+	const bool vertical = dy != 0;
+	const bool forward = vertical ? dy > 0 : dx > 0;
+	const Bitboard occupied = vertical ? state.occupiedColumnMajor : state.occupied;
+	const int index = vertical ? x * BOARD_HEIGHT + y : y * BOARD_WIDTH + x;
+
+	// All occupied tiles except the current one
+	const Bitboard candidates = occupied & ~((Bitboard) 1 << index);
+	if(!candidates) return false;
+
+	int next;
+	if(forward)
+	{
+		// The lowest occupied tile after the current one, or wrap around to the lowest one
+		const Bitboard after = index + 1 < 64 ? candidates & (~(Bitboard) 0 << (index + 1)) : 0;
+		next = bitScanForward(after ? after : candidates);
+	}
+	else
+	{
+		// The highest occupied tile before the current one, or wrap around to the highest one
+		const Bitboard before = candidates & (((Bitboard) 1 << index) - 1);
+		next = bitScanReverse(before ? before : candidates);
+	}
+
+	if(vertical)
+	{
+		x = next / BOARD_HEIGHT;
+		y = next % BOARD_HEIGHT;
+	}
+	else
+	{
+		x = next % BOARD_WIDTH;
+		y = next / BOARD_WIDTH;
+	}
+	return true;
+}
+
+// Shape names as written in the board files
+static const char *shapeNames[SHAPE_COUNT] =
+{
+	"NONE",
+	"TRIANGLE",
+	"PARALLELOGRAM",
+	"ARROW",
+	"HEXAGON_WHITE",
+	"HEXAGON_BLACK",
+	"STAR",
+	"CAKE"
+};
+
+Shape getShapeByName(const std::string &name)
+{
+	for(int shape = 0; shape < SHAPE_COUNT; shape++)
+	{
+		if(name == shapeNames[shape]) return (Shape) shape;
+	}
+	return SHAPE_COUNT;
+}
+
+const char *getShapeName(const Shape shape)
+{
+	return shape < SHAPE_COUNT ? shapeNames[shape] : "INVALID";
+}
+
+// Returns the shape named by the 'length' characters at 'name' (SHAPE_COUNT if the name is not a shape)
+static Shape getShapeByName(const char *name, const size_t length)
+{
+	for(int shape = 0; shape < SHAPE_COUNT; shape++)
+	{
+		if(strlen(shapeNames[shape]) == length && memcmp(shapeNames[shape], name, length) == 0) return (Shape) shape;
+	}
+	return SHAPE_COUNT;
+}
+
+// Sets 'error' to a message about line 'line' and clears the board
+static bool failParse(BoardState &state, std::string *error, const int line, const char *message, const char *token = 0, const size_t tokenLength = 0)
+{
+	if(error)
+	{
+		char buffer[128];
+		snprintf(buffer, sizeof(buffer), "line %d: %s", line, message);
+		*error = buffer;
+		if(token) *error += " '" + std::string(token, tokenLength) + "'";
+	}
+	clearBoardState(state, state.startWithBlue);
+	return false;
+}
+
+bool parseBoardState(const char *text, const size_t length, BoardState &state, std::string *error)
+{
+	clearBoardState(state, false);
+
+	const char *end = text + length;
+	bool colourRead = false;
+	int y = 0;
+	int line = 1;
+	for(const char *c = text; c < end; line++)
+	{
+		// Split the line into tokens
+		int x = 0;
+		while(c < end && *c != '\n')
+		{
+			if(*c == ' ' || *c == '\t' || *c == '\r')
+			{
+				c++;
+				continue;
+			}
+			const char *token = c;
+			while(c < end && *c != ' ' && *c != '\t' && *c != '\r' && *c != '\n') c++;
+			const size_t tokenLength = c - token;
+
+			if(!colourRead)
+			{
+				// The first token is the start colour, alone on its line
+				if(tokenLength == 4 && memcmp(token, "BLUE", 4) == 0) state.startWithBlue = true;
+				else if(!(tokenLength == 3 && memcmp(token, "RED", 3) == 0)) return failParse(state, error, line, "expected BLUE or RED, found", token, tokenLength);
+				state.hash = computeBoardHash(state);
+				colourRead = true;
+				x = -1;
+				continue;
+			}
+			if(x < 0) return failParse(state, error, line, "unexpected token after the start colour", token, tokenLength);
+			if(y >= BOARD_HEIGHT) return failParse(state, error, line, "too many rows");
+			if(x >= BOARD_WIDTH) return failParse(state, error, line, "too many tiles in row");
+
+			const Shape shape = getShapeByName(token, tokenLength);
+			if(shape == SHAPE_COUNT) return failParse(state, error, line, "invalid shape", token, tokenLength);
+			setTileShape(state, x++, y, shape);
+		}
+		if(c < end) c++; // Skip '\n'
+
+		// Blank lines are skipped, every other row must be complete
+		if(x > 0)
+		{
+			if(x != BOARD_WIDTH) return failParse(state, error, line, "too few tiles in row");
+			y++;
+		}
+	}
+
+	if(!colourRead) return failParse(state, error, line, "missing start colour");
+	if(y != BOARD_HEIGHT) return failParse(state, error, line, "too few rows");
+	return true;
+}
+
+bool loadBoardState(const std::string &filepath, BoardState &state, std::string *error)
+{
+	std::ifstream file(filepath, std::ios::binary);
+	if(!file)
+	{
+		if(error) *error = "could not open file";
+		clearBoardState(state, false);
+		return false;
+	}
+	const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return parseBoardState(text.data(), text.size(), state, error);
+}
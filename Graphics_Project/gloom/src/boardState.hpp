@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Board dimensions
+#define BOARD_WIDTH 8
+#define BOARD_HEIGHT 5
+#define BOARD_TILE_COUNT (BOARD_WIDTH * BOARD_HEIGHT)
+
+// Every tile of the board must fit in one Bitboard word. That keeps the occupancy index flat: the word is its own
+// summary level, and next-occupied-tile queries are a single bit scan. Larger boards need a summary level
+// (one bit per non-empty word) above an array of words.
+static_assert(BOARD_TILE_COUNT <= 64, "The board must fit in a 64-bit bitboard");
+
+// Shape types
+enum Shape
+{
+	SHAPE_NONE,
+	TRIANGLE,
+	PARALLELOGRAM,
+	ARROW,
+	HEXAGON_WHITE,
+	HEXAGON_BLACK,
+	STAR,
+	CAKE,
+	SHAPE_COUNT
+};
+
+// Tile movement
+struct TileMove
+{
+	int fromX, fromY; // Source tile
+	int toX, toY; // Destination tile
+};
+
+// One bit per tile
+typedef uint64_t Bitboard;
+
+// Render-independent board state. Every shape has a bitboard with a bit set for each tile it occupies,
+// in row-major order (bit y * BOARD_WIDTH + x). The occupancy mask is kept in both row-major and
+// column-major order (bit x * BOARD_HEIGHT + y) so that horizontal and vertical scans are both single bit scans.
+// The Zobrist hash identifies the board in O(1) and is updated incrementally on every change.
+struct BoardState
+{
+	uint64_t hash; // Zobrist hash of the shapes and the start colour
+	Bitboard shapes[SHAPE_COUNT]; // Tiles occupied by each shape (shapes[SHAPE_NONE] is unused)
+	Bitboard occupied; // Occupied tiles, row-major
+	Bitboard occupiedColumnMajor; // Occupied tiles, column-major
+	bool startWithBlue; // Start colour of the checkerboard
+};
+
+// Random keys of the Zobrist hash. The hash of a board is the xor of the keys of the shapes on its tiles,
+// xor'ed with 'startWithBlue' if the board starts with blue.
+struct ZobristKeys
+{
+	uint64_t tiles[BOARD_TILE_COUNT][SHAPE_COUNT]; // Key of every shape on every tile (0 for SHAPE_NONE)
+	uint64_t startWithBlue;
+};
+
+// Returns the Zobrist keys (the same in every run)
+const ZobristKeys &getZobristKeys();
+
+// Computes the Zobrist hash of a board from scratch
+uint64_t computeBoardHash(const BoardState &state);
+
+// Bit operations on bitboards
+int popCount(Bitboard bits);
+int bitScanForward(Bitboard bits); // Index of the lowest set bit (bits must not be 0)
+int bitScanReverse(Bitboard bits); // Index of the highest set bit (bits must not be 0)
+
+// Clears the board
+void clearBoardState(BoardState &state, const bool startWithBlue);
+
+// Tile queries and updates (all O(1))
+Shape getTileShape(const BoardState &state, const int x, const int y);
+bool isTileOccupied(const BoardState &state, const int x, const int y);
+void setTileShape(BoardState &state, const int x, const int y, const Shape shape);
+void moveTileShape(BoardState &state, const int fromX, const int fromY, const int toX, const int toY);
+
+// Returns the number of tiles occupied by 'shape'
+int countShapes(const BoardState &state, const Shape shape);
+
+// Returns true if both boards have the same shapes on the same tiles and the same start colour (hashes are compared first)
+bool isSameBoardState(const BoardState &a, const BoardState &b);
+
+// Moves [x, y] to the next occupied tile in direction [dx, dy] (one of them +-1, the other 0).
+// Horizontal moves walk the board in row-major order and vertical moves in column-major order, wrapping around.
+// If no other tile is occupied, [x, y] is left unchanged and false is returned.
+// Runs in constant time: one mask and one bit scan, whatever the number of empty tiles in between.
+bool findNextOccupiedTile(const BoardState &state, int &x, int &y, const int dx, const int dy);
+
+// Parses a board (the start colour, BLUE or RED, followed by one row of shape names per line) in a single pass
+// over 'length' characters of 'text'. Blank lines are ignored. Returns false and writes the reason to 'error'
+// (if given) if the board is malformed, in which case 'state' is left cleared rather than half-filled.
+bool parseBoardState(const char *text, const size_t length, BoardState &state, std::string *error = 0);
+
+// Reads and parses a board file. Returns false if the file can't be read or isn't a valid board.
+bool loadBoardState(const std::string &filepath, BoardState &state, std::string *error = 0);
+
+// Get shape type by shape name (SHAPE_COUNT if the name is not a shape)
+Shape getShapeByName(const std::string &name);
+
+// Get shape name by shape type
+const char *getShapeName(const Shape shape);
@@ -0,0 +1,37 @@
+#include "drawInstance.hpp"
+
+// Collects the instances below 'node', given the cumulative transformation of its parents and whether it changed
+static void collectNodeInstances(const SceneNode *node, const glm::mat4 &viewProjectionMatrix, const glm::mat4 &parentModel,
+	const bool parentChanged, std::vector<DrawInstance> &instances)
+{
+	if(node)
+	{
+		const glm::mat4 model = parentModel * node->currentTransformationMatrix;
+		const bool transformChanged = parentChanged || node->dirty;
+		if(node->meshID >= 0)
+		{
+			DrawInstance instance;
+			instance.node = node;
+			instance.meshID = node->meshID;
+			instance.material = node->materialID;
+			instance.model = model;
+			instance.modelViewProjection = viewProjectionMatrix * model;
+			instance.castsShadow = node->castsShadow;
+			instance.transformChanged = transformChanged;
+			instance.selected = 0;
+			instance.pickId = 0;
+			instance.pickColumns = 0;
+			instances.push_back(instance);
+		}
+
+		for(const SceneNode *child : node->children)
+		{
+			collectNodeInstances(child, viewProjectionMatrix, model, transformChanged, instances);
+		}
+	}
+}
+
+void collectDrawInstances(const SceneNode *node, const glm::mat4 &viewProjectionMatrix, std::vector<DrawInstance> &instances)
+{
+	collectNodeInstances(node, viewProjectionMatrix, glm::mat4(1.0f), false, instances);
+}
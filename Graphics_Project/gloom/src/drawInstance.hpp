@@ -0,0 +1,26 @@
+#pragma once
+
+#include "sceneGraph.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+// Everything a renderer needs to draw one scene node: the registered mesh, its transformation and the inputs of
+// simple.frag and id.frag. Instances are collected once per frame and drawn by the GL path or the software rasterizer.
+struct DrawInstance
+{
+	const SceneNode *node; // The node the instance was collected from
+	int meshID; // Registered mesh (see mesh.hpp)
+	uint32_t material; // Material (texture array layer, see material.hpp)
+	glm::mat4 model; // Cumulative transformation of the node (model to world space)
+	glm::mat4 modelViewProjection;
+	bool castsShadow; // The node casts shadows
+	bool transformChanged; // The node or one of its parents is dirty (SceneNode::dirty), so 'model' changed since the last frame
+	uint32_t selected; // The shape is highlighted (u_selected)
+	uint32_t pickId; // Picking ID (u_id), 0 if the node can't be picked
+	uint32_t pickColumns; // Columns of picking IDs across the mesh (u_tileColumns), 0 for one ID
+};
+
+// Appends an instance for every node with a mesh below (and including) the root node 'node' to 'instances',
+// in scene-graph order. The selection and picking fields are set to 0.
+void collectDrawInstances(const SceneNode *node, const glm::mat4 &viewProjectionMatrix, std::vector<DrawInstance> &instances);
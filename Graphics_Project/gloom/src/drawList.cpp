@@ -0,0 +1,162 @@
+#include "drawList.hpp"
+#include "jobSystem.hpp"
+#include "mesh.hpp"
+
+#include <cstring>
+#include <utility>
+
+uint64_t makeDrawKey(const DrawShader shader, const int meshID, const uint32_t material, const float depth)
+{
+	// Positive floats sort like their bit patterns, so the top bits of the float are a coarse depth
+	uint32_t depthBits = 0;
+	if(depth > 0.0f) memcpy(&depthBits, &depth, sizeof(depthBits));
+	return ((uint64_t) shader << DRAW_KEY_SHADER_SHIFT)
+		| ((uint64_t) (meshID & 0xffff) << DRAW_KEY_MESH_SHIFT)
+		| ((uint64_t) (material & 0xffff) << DRAW_KEY_MATERIAL_SHIFT)
+		| (depthBits >> (32 - DRAW_KEY_DEPTH_BITS));
+}
+
+// Returns the view depth of an instance (clip w of its origin)
+static inline float getInstanceDepth(const DrawInstance &instance)
+{
+	return instance.modelViewProjection[3][3];
+}
+
+// Returns false if the mesh bounds of the instance are entirely outside one of the clip planes
+static bool isInstanceVisible(const DrawInstance &instance)
+{
+	// The corners are the transformed minimum corner plus the transformed edges of the box
+	const Mesh &mesh = getMesh(instance.meshID);
+	const glm::mat4 &matrix = instance.modelViewProjection;
+	const glm::vec3 size = mesh.boundsMax - mesh.boundsMin;
+	const glm::vec4 origin = matrix * glm::vec4(mesh.boundsMin, 1.0f);
+	const glm::vec4 edges[3] = { matrix[0] * size.x, matrix[1] * size.y, matrix[2] * size.z };
+
+	unsigned int outside = 63; // One bit per clip plane, set while every corner is outside the plane
+	for(int corner = 0; corner < 8 && outside; corner++)
+	{
+		glm::vec4 clip = origin;
+		if(corner & 1) clip += edges[0];
+		if(corner & 2) clip += edges[1];
+		if(corner & 4) clip += edges[2];
+		outside &= (clip.x < -clip.w ? 1 : 0) | (clip.x > clip.w ? 2 : 0) | (clip.y < -clip.w ? 4 : 0)
+			| (clip.y > clip.w ? 8 : 0) | (clip.z < -clip.w ? 16 : 0) | (clip.z > clip.w ? 32 : 0);
+	}
+	return outside == 0;
+}
+
+// Appends the job buffers in order to 'commands'
+static void mergeJobCommands(const std::vector<std::vector<DrawCommand> > &jobCommands, const unsigned int jobCount, std::vector<DrawCommand> &commands)
+{
+	unsigned int count = 0;
+	for(unsigned int job = 0; job < jobCount; job++)
+	{
+		count += jobCommands[job].size();
+	}
+	commands.resize(count);
+
+	DrawCommand *destination = commands.data();
+	for(unsigned int job = 0; job < jobCount; job++)
+	{
+		if(jobCommands[job].empty()) continue;
+		memcpy(destination, jobCommands[job].data(), jobCommands[job].size() * sizeof(DrawCommand));
+		destination += jobCommands[job].size();
+	}
+}
+
+void buildDrawLists(DrawListBuilder &builder, const DrawInstance *instances, const unsigned int count,
+	std::vector<DrawCommand> &commands, std::vector<DrawCommand> *pickingCommands)
+{
+	const unsigned int jobCount = (count + DRAW_LIST_JOB_SIZE - 1) / DRAW_LIST_JOB_SIZE;
+	if(builder.jobCommands.size() < jobCount)
+	{
+		builder.jobCommands.resize(jobCount);
+		builder.jobPickingCommands.resize(jobCount);
+	}
+
+	// Cull and key the instances of every job into the job's buffers
+	parallelFor(count, DRAW_LIST_JOB_SIZE, [&](unsigned int begin, unsigned int end)
+	{
+		std::vector<DrawCommand> &jobCommands = builder.jobCommands[begin / DRAW_LIST_JOB_SIZE];
+		std::vector<DrawCommand> &jobPickingCommands = builder.jobPickingCommands[begin / DRAW_LIST_JOB_SIZE];
+		jobCommands.clear();
+		jobPickingCommands.clear();
+		for(unsigned int i = begin; i < end; i++)
+		{
+			const DrawInstance &instance = instances[i];
+			if(!isInstanceVisible(instance)) continue;
+
+			DrawCommand command;
+			command.key = makeDrawKey(DRAW_SHADER_SIMPLE, instance.meshID, instance.material, getInstanceDepth(instance));
+			command.instance = i;
+			jobCommands.push_back(command);
+
+			if(pickingCommands && instance.pickId != 0)
+			{
+				command.key = makeDrawKey(DRAW_SHADER_PICKING, instance.meshID, 0, getInstanceDepth(instance));
+				jobPickingCommands.push_back(command);
+			}
+		}
+	});
+
+	// Merge
+	mergeJobCommands(builder.jobCommands, jobCount, commands);
+	if(pickingCommands) mergeJobCommands(builder.jobPickingCommands, jobCount, *pickingCommands);
+}
+
+void buildShadowDrawList(const DrawInstance *instances, const unsigned int count, std::vector<DrawCommand> &commands)
+{
+	commands.clear();
+	for(unsigned int i = 0; i < count; i++)
+	{
+		if(!instances[i].castsShadow) continue;
+		DrawCommand command;
+		command.key = makeDrawKey(DRAW_SHADER_SHADOW, instances[i].meshID, 0, 0.0f);
+		command.instance = i;
+		commands.push_back(command);
+	}
+}
+
+void sortDrawList(std::vector<DrawCommand> &commands, std::vector<DrawCommand> &scratch)
+{
+	const unsigned int count = commands.size();
+	if(count < 2) return;
+	scratch.resize(count);
+
+	// Histograms of all eight bytes in one pass
+	unsigned int histograms[8][256];
+	memset(histograms, 0, sizeof(histograms));
+	for(const DrawCommand &command : commands)
+	{
+		for(int byte = 0; byte < 8; byte++)
+		{
+			histograms[byte][(command.key >> (byte * 8)) & 0xff]++;
+		}
+	}
+
+	// One counting sort pass per byte, from the least significant byte up. Bytes that are the same in every key
+	// (usually the shader and some of the mesh and material bits) are skipped.
+	DrawCommand *source = commands.data();
+	DrawCommand *destination = scratch.data();
+	for(int byte = 0; byte < 8; byte++)
+	{
+		unsigned int *histogram = histograms[byte];
+		if(histogram[(source[0].key >> (byte * 8)) & 0xff] == count) continue;
+
+		unsigned int offset = 0;
+		for(int digit = 0; digit < 256; digit++)
+		{
+			const unsigned int digitCount = histogram[digit];
+			histogram[digit] = offset;
+			offset += digitCount;
+		}
+		for(unsigned int i = 0; i < count; i++)
+		{
+			destination[histogram[(source[i].key >> (byte * 8)) & 0xff]++] = source[i];
+		}
+		std::swap(source, destination);
+	}
+
+	// The result ends up in the scratch buffer after an odd number of passes
+	if(source != commands.data()) commands.swap(scratch);
+}
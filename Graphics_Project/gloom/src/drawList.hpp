@@ -0,0 +1,79 @@
+#pragma once
+
+#include "drawInstance.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+// Draw lists are sorted by a 64-bit key, so that draws that share state end up next to each other and the backend
+// only has to change the state that differs between consecutive draws. From the most significant bits down:
+//     shader (8 bits) | mesh (16 bits) | material (16 bits) | depth (24 bits)
+// Opaque draws are sorted front to back within a mesh and material, which helps the depth test reject fragments early.
+
+#define DRAW_KEY_SHADER_SHIFT 56
+#define DRAW_KEY_MESH_SHIFT 40
+#define DRAW_KEY_MATERIAL_SHIFT 24
+#define DRAW_KEY_DEPTH_BITS 24
+
+// Shaders of the draw lists
+enum DrawShader
+{
+	DRAW_SHADER_SIMPLE, // simple.vert and simple.frag
+	DRAW_SHADER_PICKING, // id.vert and id.frag
+	DRAW_SHADER_SHADOW // shadow.vert and shadow.frag
+};
+
+// State that changes between two draws
+enum DrawStateChange
+{
+	DRAW_STATE_SHADER = 1,
+	DRAW_STATE_MESH = 2,
+	DRAW_STATE_MATERIAL = 4,
+	DRAW_STATE_ALL = 7
+};
+
+// One draw of a draw list
+struct DrawCommand
+{
+	uint64_t key; // Sort key (see makeDrawKey())
+	uint32_t instance; // Index into the instances of the frame (see RenderBackend::updateInstances())
+};
+
+// Returns the sort key of a draw. 'depth' is the view depth of the instance (negative depths are clamped to 0).
+uint64_t makeDrawKey(const DrawShader shader, const int meshID, const uint32_t material, const float depth);
+
+// Returns the state that differs between a draw with key 'previousKey' and the next draw with key 'key'
+inline unsigned int getDrawStateChanges(const uint64_t previousKey, const uint64_t key)
+{
+	const uint64_t difference = previousKey ^ key;
+	return (difference >> DRAW_KEY_SHADER_SHIFT ? DRAW_STATE_SHADER : 0)
+		| ((difference >> DRAW_KEY_MESH_SHIFT) & 0xffff ? DRAW_STATE_MESH : 0)
+		| ((difference >> DRAW_KEY_MATERIAL_SHIFT) & 0xffff ? DRAW_STATE_MATERIAL : 0);
+}
+
+// Instances per job of a draw list build
+#define DRAW_LIST_JOB_SIZE 256
+
+// Per-job buffers of draw list builds, kept between frames so they don't have to be reallocated
+struct DrawListBuilder
+{
+	std::vector<std::vector<DrawCommand> > jobCommands;
+	std::vector<std::vector<DrawCommand> > jobPickingCommands;
+};
+
+// Builds the draw lists of a frame on the job system (see jobSystem.hpp). Every job takes DRAW_LIST_JOB_SIZE instances,
+// culls them against the view frustum and writes the keyed commands of the visible ones to its own buffers, which are
+// then merged in job order, so the lists don't depend on the number of threads. 'commands' gets a draw of every
+// visible instance with the simple shader and the instance's material. If 'pickingCommands' is given, it gets
+// a draw of every visible instance that can be picked (pickId != 0) with the picking shader.
+void buildDrawLists(DrawListBuilder &builder, const DrawInstance *instances, const unsigned int count,
+	std::vector<DrawCommand> &commands, std::vector<DrawCommand> *pickingCommands);
+
+// Builds the draw list of the shadow casters of a frame: a draw of every instance that casts shadows with the shadow
+// shader, keyed by mesh. Casters aren't culled against the view frustum, since they can shadow what's in view from
+// outside of it.
+void buildShadowDrawList(const DrawInstance *instances, const unsigned int count, std::vector<DrawCommand> &commands);
+
+// Sorts the commands by key with a stable LSD radix sort (draws with equal keys stay in submission order).
+// 'scratch' is used as temporary storage, keeping it between frames avoids reallocating it.
+void sortDrawList(std::vector<DrawCommand> &commands, std::vector<DrawCommand> &scratch);
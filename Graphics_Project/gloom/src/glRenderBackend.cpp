@@ -0,0 +1,383 @@
+#include "glRenderBackend.hpp"
+#include "idBuffer.hpp"
+#include "jobSystem.hpp"
+#include "uploadRing.hpp"
+#include "gloom/shader.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// Instances of the upload ring in the first frames (it grows when a frame needs more)
+#define GL_BACKEND_INITIAL_INSTANCES 1024
+
+// Layers of the material texture array when it's created (it grows when more materials are created)
+#define GL_BACKEND_INITIAL_MATERIALS 16
+
+// Per-instance data of the shaders (std430 layout of Instance in simple.vert and id.vert)
+struct GpuInstance
+{
+	glm::mat4 modelViewProjection;
+	uint32_t selected;
+	uint32_t pickId;
+	uint32_t pickColumns;
+	uint32_t material;
+};
+
+struct GLRenderBackend : RenderBackend
+{
+	int width, height;
+
+	// VAO, buffers and index count of every registered mesh
+	std::vector<GLuint> vertexArrays;
+	std::vector<GLuint> buffers;
+	std::vector<GLsizei> indexCounts;
+
+	// Texture array with a layer per material
+	GLuint materialTexture;
+	TextureFormat materialFormat; // Format of every layer (set by the first material)
+	int materialCapacity; // Layers allocated
+	int materialCount; // Layers created
+
+	Gloom::Shader shader;
+	Gloom::Shader idShader;
+	Gloom::Shader shadowShader;
+	IdBuffer idBuffer;
+	UploadRing uploadRing;
+
+	// Depth texture array with a layer per shadow cascade, the framebuffer they are drawn through, and the cascades
+	// the colour pass reads (see setShadowCascades())
+	GLuint shadowTexture;
+	GLuint shadowFramebuffer;
+	glm::mat4 cascadeMatrices[SHADOW_CASCADE_COUNT];
+	glm::vec4 cascadeSplits;
+	glm::mat4 inverseViewProjection;
+
+	std::vector<DrawInstance> instances;
+	uint64_t frames;
+
+	GLRenderBackend(const int width, const int height) : width(width), height(height)
+	{
+		// Enable depth (Z) buffer (accept "closest" fragment)
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LESS);
+
+		// Configure miscellaneous OpenGL settings
+		glEnable(GL_CULL_FACE);
+
+		// Load our shaders
+		shader.attach("../gloom/shaders/simple.vert");
+		shader.attach("../gloom/shaders/simple.frag");
+		shader.link();
+		idShader.attach("../gloom/shaders/id.vert");
+		idShader.attach("../gloom/shaders/id.frag");
+		idShader.link();
+		shadowShader.attach("../gloom/shaders/shadow.vert");
+		shadowShader.attach("../gloom/shaders/shadow.frag");
+		shadowShader.link();
+
+		// Shadow maps, compared against the fragment depth when sampled (2x2 filtered). Outside the maps is lit.
+		static const float shadowBorder[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		glGenTextures(1, &shadowTexture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, shadowTexture);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT24, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, SHADOW_CASCADE_COUNT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, shadowBorder);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		glGenFramebuffers(1, &shadowFramebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, shadowFramebuffer);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		for(int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+		{
+			cascadeMatrices[cascade] = glm::mat4(1.0f);
+		}
+		cascadeSplits = glm::vec4(0.0f); // No shadows until the cascades are set
+		inverseViewProjection = glm::mat4(1.0f);
+
+		// GPU picking
+		idBuffer = createIdBuffer(width, height);
+
+		// Materials are created with setMaterialRenderBackend()
+		materialTexture = 0;
+		materialFormat = TEXTURE_FORMAT_RGBA8;
+		materialCapacity = 0;
+		materialCount = 0;
+
+		// Per-frame instance data
+		uploadRing = createUploadRing(GL_BACKEND_INITIAL_INSTANCES * sizeof(GpuInstance));
+		frames = 0;
+	}
+
+	~GLRenderBackend()
+	{
+		destroyUploadRing(uploadRing);
+		destroyIdBuffer(idBuffer);
+		glDeleteFramebuffers(1, &shadowFramebuffer);
+		glDeleteTextures(1, &shadowTexture);
+		shadowShader.destroy();
+		glDeleteTextures(1, &materialTexture);
+		idShader.destroy();
+		shader.destroy();
+		glDeleteVertexArrays(vertexArrays.size(), vertexArrays.data());
+		glDeleteBuffers(buffers.size(), buffers.data());
+	}
+
+	void createMesh(const int meshID, const Mesh &mesh)
+	{
+		// Generate and bind Vertex Array Object
+		GLuint vaoID, vboID, iboID;
+		glGenVertexArrays(1, &vaoID);
+		glBindVertexArray(vaoID);
+
+		// Generate Vertex Buffer Object and upload the vertex data
+		glGenBuffers(1, &vboID);
+		glBindBuffer(GL_ARRAY_BUFFER, vboID);
+		glBufferData(GL_ARRAY_BUFFER, mesh.vertexData.size() * sizeof(float), mesh.vertexData.data(), GL_STATIC_DRAW);
+
+		// Set and enable vertex attribute pointers for the VBO
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, MESH_VERTEX_STRIDE * sizeof(float), 0);
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, MESH_VERTEX_STRIDE * sizeof(float), (void*) (3 * sizeof(float)));
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+
+		// Generate Index Buffer Object and upload the index data
+		glGenBuffers(1, &iboID);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboID);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+
+		// Unbind VAO
+		glBindVertexArray(0);
+
+		if(vertexArrays.size() <= (size_t) meshID)
+		{
+			vertexArrays.resize(meshID + 1, 0);
+			indexCounts.resize(meshID + 1, 0);
+		}
+		vertexArrays[meshID] = vaoID;
+		indexCounts[meshID] = mesh.indices.size();
+		buffers.push_back(vboID);
+		buffers.push_back(iboID);
+	}
+
+	void createMaterial(const int materialID, const TextureLayer &texture)
+	{
+		static const GLenum internalFormats[TEXTURE_FORMAT_COUNT] =
+		{
+			GL_RGBA8, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+		};
+		if(materialCount == 0) materialFormat = texture.format;
+		if(texture.format != materialFormat)
+		{
+			fprintf(stderr, "Material %i is %s, but the material texture array is %s\n", materialID,
+				getTextureFormatName(texture.format), getTextureFormatName(materialFormat));
+			return;
+		}
+
+		// Grow the texture array when it's full, copying the layers created so far
+		if(materialID >= materialCapacity)
+		{
+			const int capacity = std::max(std::max(GL_BACKEND_INITIAL_MATERIALS, 2 * materialCapacity), materialID + 1);
+			GLuint textureID;
+			glGenTextures(1, &textureID);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+			glTexStorage3D(GL_TEXTURE_2D_ARRAY, TEXTURE_MIP_COUNT, internalFormats[materialFormat], TEXTURE_LAYER_SIZE, TEXTURE_LAYER_SIZE, capacity);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			for(int mip = 0; materialTexture && mip < TEXTURE_MIP_COUNT; mip++)
+			{
+				glCopyImageSubData(materialTexture, GL_TEXTURE_2D_ARRAY, mip, 0, 0, 0, textureID, GL_TEXTURE_2D_ARRAY, mip, 0, 0, 0,
+					getTextureMipSize(mip), getTextureMipSize(mip), materialCount);
+			}
+			glDeleteTextures(1, &materialTexture);
+			materialTexture = textureID;
+			materialCapacity = capacity;
+		}
+
+		// Upload the precomputed (and compressed) mips
+		glBindTexture(GL_TEXTURE_2D_ARRAY, materialTexture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		for(int mip = 0; mip < TEXTURE_MIP_COUNT; mip++)
+		{
+			const int size = getTextureMipSize(mip);
+			const uint8_t *data = &texture.data[getTextureMipOffset(texture.format, mip)];
+			if(texture.format == TEXTURE_FORMAT_RGBA8)
+			{
+				glTexSubImage3D(GL_TEXTURE_2D_ARRAY, mip, 0, 0, materialID, size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+			}
+			else
+			{
+				glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, mip, 0, 0, materialID, size, size, 1, internalFormats[materialFormat],
+					getTextureMipBytes(texture.format, mip), data);
+			}
+		}
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		materialCount = std::max(materialCount, materialID + 1);
+	}
+
+	void updateInstances(const DrawInstance *newInstances, const unsigned int count)
+	{
+		instances.assign(newInstances, newInstances + count);
+	}
+
+	void beginFrame(const glm::vec4 &clearColor)
+	{
+		// Take the upload region of this frame (waits if the GPU is still reading it)
+		beginUploadRegion(uploadRing);
+
+		// Clear colour and depth buffers
+		glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+
+	// Writes the instances of 'commands' in order to the upload ring and binds them as the instance buffer. The
+	// instances are packed in parallel jobs, which only write to the mapped memory (the GL calls stay on this thread).
+	// With 'lightViewProjection', the instances are transformed by it instead of the camera (for a shadow pass).
+	void uploadDrawList(const DrawCommand *commands, const unsigned int count, const glm::mat4 *lightViewProjection = 0)
+	{
+		GLintptr offset;
+		char *data = (char*) reserveUpload(uploadRing, count * sizeof(GpuInstance), offset);
+		const std::vector<DrawInstance> &frameInstances = instances;
+		parallelFor(count, DRAW_LIST_JOB_SIZE, [commands, data, &frameInstances, lightViewProjection](unsigned int begin, unsigned int end)
+		{
+			for(unsigned int i = begin; i < end; i++)
+			{
+				const DrawInstance &instance = frameInstances[commands[i].instance];
+				GpuInstance gpuInstance;
+				gpuInstance.modelViewProjection = lightViewProjection ? *lightViewProjection * instance.model : instance.modelViewProjection;
+				gpuInstance.selected = instance.selected;
+				gpuInstance.pickId = instance.pickId;
+				gpuInstance.pickColumns = instance.pickColumns;
+				gpuInstance.material = instance.material;
+				memcpy(data + i * sizeof(GpuInstance), &gpuInstance, sizeof(GpuInstance));
+			}
+		});
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, uploadRing.buffer, offset, count * sizeof(GpuInstance));
+	}
+
+	// Draws the uploaded commands with one instanced draw per run of commands with the same mesh
+	void drawMeshRuns(const DrawCommand *commands, const unsigned int count)
+	{
+		unsigned int first = 0;
+		for(unsigned int i = 1; i <= count; i++)
+		{
+			if(i < count && !(getDrawStateChanges(commands[i - 1].key, commands[i].key) & DRAW_STATE_MESH)) continue;
+
+			const int meshID = instances[commands[first].instance].meshID;
+			glBindVertexArray(vertexArrays[meshID]);
+			glUniform1ui(0, first);
+			glDrawElementsInstanced(GL_TRIANGLES, indexCounts[meshID], GL_UNSIGNED_INT, 0, i - first);
+			first = i;
+		}
+		glBindVertexArray(0);
+	}
+
+	void submitShadowPass(const int cascade, const glm::mat4 &lightViewProjection, const DrawCommand *commands, const unsigned int count)
+	{
+		// Draw the casters into the cascade's layer, offset away from the light against shadow acne. Casters between
+		// the light and the near plane are clamped to it instead of clipped.
+		glBindFramebuffer(GL_FRAMEBUFFER, shadowFramebuffer);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowTexture, 0, cascade);
+		glViewport(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		if(count > 0)
+		{
+			uploadDrawList(commands, count, &lightViewProjection);
+			glEnable(GL_DEPTH_CLAMP);
+			glEnable(GL_POLYGON_OFFSET_FILL);
+			glPolygonOffset(2.0f, 4.0f);
+			shadowShader.activate();
+			drawMeshRuns(commands, count);
+			shadowShader.deactivate();
+			glDisable(GL_POLYGON_OFFSET_FILL);
+			glDisable(GL_DEPTH_CLAMP);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, width, height);
+	}
+
+	void setShadowCascades(const ShadowCascade *cascades, const glm::mat4 &cameraInverseViewProjection)
+	{
+		for(int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+		{
+			cascadeMatrices[cascade] = cascades[cascade].viewProjection;
+			cascadeSplits[cascade] = cascades[cascade].splitDepth;
+		}
+		inverseViewProjection = cameraInverseViewProjection;
+	}
+
+	void submitDrawList(const DrawCommand *commands, const unsigned int count)
+	{
+		if(count == 0) return;
+		uploadDrawList(commands, count);
+		shader.activate();
+		glUniformMatrix4fv(1, 1, GL_FALSE, &inverseViewProjection[0][0]);
+		glUniform4fv(2, 1, &cascadeSplits[0]);
+		glUniformMatrix4fv(3, SHADOW_CASCADE_COUNT, GL_FALSE, &cascadeMatrices[0][0][0]);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, materialTexture);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, shadowTexture);
+		drawMeshRuns(commands, count);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		shader.deactivate();
+	}
+
+	bool submitPickingPass(const DrawCommand *commands, const unsigned int count, const int x, const int y)
+	{
+		if(count > 0) uploadDrawList(commands, count);
+		beginIdPass(idBuffer);
+		idShader.activate();
+		if(count > 0) drawMeshRuns(commands, count);
+		idShader.deactivate();
+		endIdPass(idBuffer, x, y);
+		glViewport(0, 0, width, height);
+		return true;
+	}
+
+	bool pollPickingResult(uint32_t &id)
+	{
+		return pollIdBuffer(idBuffer, id);
+	}
+
+	void endFrame()
+	{
+		// The GPU may write over the frame's upload region once it's done drawing
+		endUploadRegion(uploadRing);
+		frames++;
+	}
+
+	RenderStats getStats() const
+	{
+		RenderStats stats;
+		stats.frames = frames;
+		stats.uploadBytes = uploadRing.bytesUploaded;
+		stats.uploadWaits = uploadRing.waits;
+		return stats;
+	}
+
+	bool readFrame(std::vector<uint32_t> &pixels, int &frameWidth, int &frameHeight)
+	{
+		frameWidth = width;
+		frameHeight = height;
+		pixels.resize(width * height);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		return true;
+	}
+};
+
+RenderBackend *createGLRenderBackend(const int width, const int height)
+{
+	return new GLRenderBackend(width, height);
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "renderBackend.hpp"
+
+// Creates the OpenGL 4.4 backend for a framebuffer of 'width' x 'height' pixels. Sets up the GL state and loads the
+// shaders, so the context must be current.
+RenderBackend *createGLRenderBackend(const int width, const int height);
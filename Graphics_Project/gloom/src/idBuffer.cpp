@@ -0,0 +1,113 @@
+#include "idBuffer.hpp"
+
+#include <cstdio>
+
+IdBuffer createIdBuffer(const int width, const int height)
+{
+	IdBuffer idBuffer;
+	idBuffer.width = width;
+	idBuffer.height = height;
+	idBuffer.nextReadback = 0;
+
+	// ID and depth attachments
+	glGenTextures(1, &idBuffer.idTexture);
+	glBindTexture(GL_TEXTURE_2D, idBuffer.idTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenRenderbuffers(1, &idBuffer.depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, idBuffer.depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &idBuffer.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, idBuffer.framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, idBuffer.idTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, idBuffer.depthBuffer);
+	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		fprintf(stderr, "ID buffer framebuffer is incomplete\n");
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// Readback ring
+	glGenBuffers(ID_BUFFER_READBACK_COUNT, idBuffer.pixelBuffers);
+	for(int i = 0; i < ID_BUFFER_READBACK_COUNT; i++)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, idBuffer.pixelBuffers[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(uint32_t), 0, GL_STREAM_READ);
+		idBuffer.fences[i] = 0;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	return idBuffer;
+}
+
+void destroyIdBuffer(IdBuffer &idBuffer)
+{
+	for(int i = 0; i < ID_BUFFER_READBACK_COUNT; i++)
+	{
+		if(idBuffer.fences[i]) glDeleteSync(idBuffer.fences[i]);
+		idBuffer.fences[i] = 0;
+	}
+	glDeleteBuffers(ID_BUFFER_READBACK_COUNT, idBuffer.pixelBuffers);
+	glDeleteFramebuffers(1, &idBuffer.framebuffer);
+	glDeleteRenderbuffers(1, &idBuffer.depthBuffer);
+	glDeleteTextures(1, &idBuffer.idTexture);
+}
+
+void beginIdPass(IdBuffer &idBuffer)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, idBuffer.framebuffer);
+	glViewport(0, 0, idBuffer.width, idBuffer.height);
+
+	const GLuint clearId[4] = { 0, 0, 0, 0 };
+	glClearBufferuiv(GL_COLOR, 0, clearId);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void endIdPass(IdBuffer &idBuffer, const int x, const int y)
+{
+	// Copy the pixel into the next free pixel buffer, the copy runs asynchronously
+	const unsigned int slot = idBuffer.nextReadback;
+	if(!idBuffer.fences[slot] && x >= 0 && y >= 0 && x < idBuffer.width && y < idBuffer.height)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, idBuffer.pixelBuffers[slot]);
+		glReadPixels(x, y, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		idBuffer.fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		idBuffer.nextReadback = (slot + 1) % ID_BUFFER_READBACK_COUNT;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool pollIdBuffer(IdBuffer &idBuffer, uint32_t &id)
+{
+	// Visit the slots from the oldest readback to the newest
+	bool found = false;
+	for(int i = 0; i < ID_BUFFER_READBACK_COUNT; i++)
+	{
+		const unsigned int slot = (idBuffer.nextReadback + i) % ID_BUFFER_READBACK_COUNT;
+		if(!idBuffer.fences[slot]) continue;
+
+		// Stop at the first readback that isn't done, the newer ones can't be done either
+		const GLenum status = glClientWaitSync(idBuffer.fences[slot], 0, 0);
+		if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+		glDeleteSync(idBuffer.fences[slot]);
+		idBuffer.fences[slot] = 0;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, idBuffer.pixelBuffers[slot]);
+		const uint32_t *pixel = (const uint32_t*) glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(uint32_t), GL_MAP_READ_BIT);
+		if(pixel)
+		{
+			id = *pixel;
+			found = true;
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+	return found;
+}
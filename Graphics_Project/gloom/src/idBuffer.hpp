@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <stdint.h>
+
+// Integer render target that objects write their IDs to, for picking on the GPU. The ID under a pixel is copied
+// into a pixel buffer object and read back once its fence has signalled, usually a frame later, so reading it
+// never stalls the pipeline. ID 0 means nothing was drawn.
+
+// Readbacks that can be in flight at once
+#define ID_BUFFER_READBACK_COUNT 3
+
+// ID buffer
+struct IdBuffer
+{
+	GLuint framebuffer;
+	GLuint idTexture; // GL_R32UI colour attachment
+	GLuint depthBuffer;
+	int width, height;
+	GLuint pixelBuffers[ID_BUFFER_READBACK_COUNT]; // Ring of one-pixel readback buffers
+	GLsync fences[ID_BUFFER_READBACK_COUNT]; // Fence of every readback in flight (0 if the slot is free)
+	unsigned int nextReadback; // Next slot in the ring
+};
+
+// Creates an ID buffer of 'width' x 'height' pixels
+IdBuffer createIdBuffer(const int width, const int height);
+
+// Deletes the GL objects of the ID buffer
+void destroyIdBuffer(IdBuffer &idBuffer);
+
+// Binds the ID buffer as the render target and clears it to ID 0
+void beginIdPass(IdBuffer &idBuffer);
+
+// Queues the readback of the ID at pixel [x, y] (from the bottom left) and binds the default framebuffer again.
+// If every readback slot is still in flight, no readback is queued this time.
+void endIdPass(IdBuffer &idBuffer, const int x, const int y);
+
+// Writes the ID of the most recent readback that has finished to 'id' and returns true, or returns false if none
+// has finished since the last call. Never waits for the GPU.
+bool pollIdBuffer(IdBuffer &idBuffer, uint32_t &id);
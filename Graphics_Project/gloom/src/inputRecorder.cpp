@@ -0,0 +1,89 @@
+#include "inputRecorder.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+InputLog createInputLog()
+{
+	InputLog log;
+	log.replayIndex = 0;
+	return log;
+}
+
+void recordInputEvent(InputLog &log, const InputEvent &event)
+{
+	log.events.push_back(event);
+}
+
+bool saveInputLog(const InputLog &log, const std::string &filepath)
+{
+	FILE *file = fopen(filepath.c_str(), "w");
+	if(!file) return false;
+
+	// Header, then "<tick> K <key> <action>", "<tick> C <x> <y>" or "<tick> M <button> <action> <x> <y> <tile>" per event.
+	// Cursor positions are written with enough digits to be read back exactly.
+	fprintf(file, "INPUTLOG 1\n");
+	for(const InputEvent &event : log.events)
+	{
+		if(event.type == INPUT_KEY) fprintf(file, "%u K %d %d\n", event.tick, event.key, event.action);
+		else if(event.type == INPUT_CURSOR_POS) fprintf(file, "%u C %.17g %.17g\n", event.tick, event.x, event.y);
+		else fprintf(file, "%u M %d %d %.17g %.17g %d\n", event.tick, event.key, event.action, event.x, event.y, event.pickedTile);
+	}
+	return fclose(file) == 0;
+}
+
+bool loadInputLog(InputLog &log, const std::string &filepath)
+{
+	log = createInputLog();
+
+	std::ifstream file(filepath);
+	std::string line;
+	if(!getline(file, line) || line != "INPUTLOG 1") return false;
+
+	while(getline(file, line))
+	{
+		if(line.empty()) continue;
+
+		std::istringstream ss(line);
+		InputEvent event = {};
+		std::string type;
+		if(!(ss >> event.tick >> type)) return false;
+		if(type == "K")
+		{
+			event.type = INPUT_KEY;
+			if(!(ss >> event.key >> event.action)) return false;
+		}
+		else if(type == "C")
+		{
+			event.type = INPUT_CURSOR_POS;
+			if(!(ss >> event.x >> event.y)) return false;
+		}
+		else if(type == "M")
+		{
+			event.type = INPUT_MOUSE_BUTTON;
+			if(!(ss >> event.key >> event.action >> event.x >> event.y >> event.pickedTile)) return false;
+		}
+		else
+		{
+			return false;
+		}
+
+		// Events must be in tick order
+		if(!log.events.empty() && event.tick < log.events.back().tick) return false;
+		log.events.push_back(event);
+	}
+	return true;
+}
+
+bool nextReplayEvent(InputLog &log, const uint32_t tick, InputEvent &event)
+{
+	if(log.replayIndex >= log.events.size() || log.events[log.replayIndex].tick > tick) return false;
+	event = log.events[log.replayIndex++];
+	return true;
+}
+
+bool isReplayFinished(const InputLog &log)
+{
+	return log.replayIndex >= log.events.size();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Input events stamped with the simulation tick they are applied on. Because the simulation runs at a fixed
+// tick rate, applying the same events on the same ticks reproduces a session exactly, at any frame rate.
+
+// Input event types
+enum InputEventType
+{
+	INPUT_KEY, // GLFW key event
+	INPUT_CURSOR_POS, // GLFW cursor position event
+	INPUT_MOUSE_BUTTON // GLFW mouse button event
+};
+
+// Input event
+struct InputEvent
+{
+	uint32_t tick; // Simulation tick the event is applied on
+	InputEventType type;
+	int key, action; // Key or mouse button, and action (INPUT_KEY and INPUT_MOUSE_BUTTON)
+	double x, y; // Cursor position (INPUT_CURSOR_POS), or the clicked point in normalized device coordinates (INPUT_MOUSE_BUTTON)
+	int pickedTile; // Tile already picked on the GPU, or -1 to pick with a ray through [x, y] (INPUT_MOUSE_BUTTON)
+};
+
+// Ordered list of input events, and the replay position
+struct InputLog
+{
+	std::vector<InputEvent> events;
+	unsigned int replayIndex; // Next event to replay
+};
+
+// Creates an empty input log
+InputLog createInputLog();
+
+// Appends an event (events must be appended in tick order)
+void recordInputEvent(InputLog &log, const InputEvent &event);
+
+// Writes the log to 'filepath' as text, one event per line. Returns false if the file can't be written.
+bool saveInputLog(const InputLog &log, const std::string &filepath);
+
+// Reads a log written by saveInputLog(). Returns false if the file can't be read or is malformed.
+bool loadInputLog(InputLog &log, const std::string &filepath);
+
+// Returns the next replayed event on tick 'tick' in 'event', or false if there are no more events on this tick
+bool nextReplayEvent(InputLog &log, const uint32_t tick, InputEvent &event);
+
+// Returns true if every event has been replayed
+bool isReplayFinished(const InputLog &log);
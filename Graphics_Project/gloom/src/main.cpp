@@ -1,6 +1,7 @@
 // Local headers
 #include "gloom/gloom.hpp"
 #include "program.hpp"
+#include "jobSystem.hpp"
 
 // System headers
 #include <glad/glad.h>
@@ -8,6 +9,7 @@
 
 // Standard headers
 #include <cstdlib>
+#include <string>
 
 extern "C" {
 	_declspec(dllexport) DWORD NvOptimusEnablement = 0x00000001;
@@ -20,7 +22,7 @@ static void glfwErrorCallback(int error, const char *description)
 }
 
 
-GLFWwindow* initialise()
+GLFWwindow* initialise(const bool visible)
 {
     // Initialise GLFW
     if (!glfwInit())
@@ -31,7 +33,7 @@ GLFWwindow* initialise()
 
     // Set core window options (adjust version numbers if needed)
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
     // Enable the GLFW runtime error callback function defined previously.
@@ -40,6 +42,7 @@ GLFWwindow* initialise()
     // Set additional window options
     glfwWindowHint(GLFW_RESIZABLE, windowResizable);
     glfwWindowHint(GLFW_SAMPLES, windowSamples);  // MSAA
+    glfwWindowHint(GLFW_VISIBLE, visible);
 
     // Create window using GLFW
     GLFWwindow* window = glfwCreateWindow(windowWidth,
@@ -72,11 +75,43 @@ GLFWwindow* initialise()
 
 int main(int argc, char* argb[])
 {
-    // Initialise window using GLFW
-    GLFWwindow* window = initialise();
+    // Parse command line options (--record <file>, --replay <file>, --solve <board> and --no-render)
+    ProgramOptions options;
+    options.render = true;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argb[i];
+        if (arg == "--record" && i + 1 < argc) options.recordPath = argb[++i];
+        else if (arg == "--replay" && i + 1 < argc) options.replayPath = argb[++i];
+        else if (arg == "--solve" && i + 1 < argc) options.solveTarget = argb[++i];
+        else if (arg == "--no-render") options.render = false;
+        else
+        {
+            fprintf(stderr, "Usage: %s [--record <file>] [--replay <file>] [--solve <board>] [--no-render]\n", argb[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Without a replay nothing would drive a hidden window, so --no-render is only allowed together with --replay
+    if (!options.render && options.replayPath.empty())
+    {
+        fprintf(stderr, "--no-render requires --replay <file>\n");
+        fprintf(stderr, "Usage: %s [--record <file>] [--replay <file>] [--solve <board>] [--no-render]\n", argb[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Initialise window using GLFW (with --no-render it stays hidden and the recording backend makes no GL calls,
+    // but the window is still created because GLFW input and time need it, so a replay still needs a display)
+    GLFWwindow* window = initialise(options.render);
+
+    // Start the worker threads
+    initJobSystem();
 
     // Run an OpenGL application using this window
-    runProgram(window);
+    runProgram(window, options);
+
+    // Stop the worker threads
+    shutdownJobSystem();
 
     // Terminate GLFW (no need to call glfwDestroyWindow)
     glfwTerminate();
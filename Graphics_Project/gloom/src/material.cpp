@@ -0,0 +1,87 @@
+#include "material.hpp"
+#include "renderBackend.hpp"
+
+#include <cstdio>
+#include <deque>
+#include <map>
+
+// The material registry (a deque keeps references to the textures valid)
+static std::deque<TextureLayer> textures;
+static std::map<std::string, int> materialIDs;
+static RenderBackend *materialRenderBackend = 0;
+
+// Adds a texture to the registry and creates it on the render backend
+static int registerMaterial(const TextureLayer &texture)
+{
+	const int materialID = textures.size();
+	textures.push_back(texture);
+	if(materialRenderBackend) materialRenderBackend->createMaterial(materialID, textures.back());
+	return materialID;
+}
+
+// Returns true if the file 'filepath' exists (and can be opened)
+static bool fileExists(const std::string &filepath)
+{
+	FILE *file = fopen(filepath.c_str(), "rb");
+	if(file) fclose(file);
+	return file != 0;
+}
+
+// Registers the white material 0
+static void registerWhiteMaterial()
+{
+	if(!textures.empty()) return;
+	TextureLayer white;
+	createSolidTextureLayer(glm::vec4(1.0f), MATERIAL_TEXTURE_FORMAT, white);
+	registerMaterial(white);
+}
+
+int getMaterial(const std::string &name)
+{
+	registerWhiteMaterial();
+	std::map<std::string, int>::const_iterator it = materialIDs.find(name);
+	if(it != materialIDs.end()) return it->second;
+
+	// Load the texture. Materials don't need one, without it they are white (and that isn't an error).
+	const std::string filepath = std::string(MATERIAL_TEXTURE_DIRECTORY) + "/" + name + ".png";
+	TextureLayer texture;
+	bool fromCache;
+	std::string error;
+	int materialID = 0;
+	if(!fileExists(filepath))
+	{
+		// Untextured
+	}
+	else if(loadTextureLayer(filepath, MATERIAL_CACHE_DIRECTORY, MATERIAL_TEXTURE_FORMAT, texture, &fromCache, &error))
+	{
+		materialID = registerMaterial(texture);
+		printf("Material %i: '%s' %s, %s %.1f KB\n", materialID, filepath.c_str(), fromCache ? "from cache" : "decoded",
+			getTextureFormatName(texture.format), texture.data.size() / 1024.0f);
+	}
+	else
+	{
+		fprintf(stderr, "Material '%s' is white: '%s' %s\n", name.c_str(), filepath.c_str(), error.c_str());
+	}
+	materialIDs[name] = materialID;
+	return materialID;
+}
+
+void setMaterialRenderBackend(RenderBackend *backend)
+{
+	registerWhiteMaterial();
+	materialRenderBackend = backend;
+	for(unsigned int materialID = 0; backend && materialID < textures.size(); materialID++)
+	{
+		backend->createMaterial(materialID, textures[materialID]);
+	}
+}
+
+const TextureLayer &getMaterialTexture(const int materialID)
+{
+	return textures[materialID];
+}
+
+int getMaterialCount()
+{
+	return textures.size();
+}
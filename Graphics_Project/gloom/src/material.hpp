@@ -0,0 +1,33 @@
+#pragma once
+
+#include "textureLoader.hpp"
+
+#include <string>
+
+struct RenderBackend;
+
+// Texture materials. Every material is a layer of one texture array on the render backend, and instances select
+// their layer by index, so instances with different materials can still be drawn together. The texture of material
+// 'name' is MATERIAL_TEXTURE_DIRECTORY/name.png, multiplied with the vertex colours. Material 0 is white (no texture).
+// No textures ship with the project, so every material is white until a PNG is put in the texture directory.
+
+// Where the textures are, and where their decoded copies are cached (relative to the working directory)
+#define MATERIAL_TEXTURE_DIRECTORY "../gloom/textures"
+#define MATERIAL_CACHE_DIRECTORY "textureCache"
+
+// Format of the material textures. simple.frag only uses the colour of the textures, so BC1 is enough (BC3 keeps alpha).
+#define MATERIAL_TEXTURE_FORMAT TEXTURE_FORMAT_BC1
+
+// Returns the ID of the material 'name', loading its texture the first time and creating it on the render backend
+// (if one is set). Materials without a texture are white, so the vertex colours show through unchanged. A texture
+// that exists but can't be loaded is reported, and the material is white too.
+int getMaterial(const std::string &name);
+
+// Sets the render backend that materials are created on, and creates the materials loaded so far on it
+void setMaterialRenderBackend(RenderBackend *backend);
+
+// Returns the texture of material 'materialID'
+const TextureLayer &getMaterialTexture(const int materialID);
+
+// Returns the number of materials
+int getMaterialCount();
@@ -0,0 +1,52 @@
+#include "mesh.hpp"
+#include "meshOptimizer.hpp"
+#include "renderBackend.hpp"
+
+#include <cfloat>
+#include <deque>
+
+// The mesh registry (a deque keeps references to registered meshes valid)
+static std::deque<Mesh> meshes;
+static RenderBackend *meshRenderBackend = 0;
+
+int registerMesh(const Mesh &mesh, const bool sortForOverdraw)
+{
+	const int meshID = meshes.size();
+	meshes.push_back(mesh);
+	Mesh &registeredMesh = meshes.back();
+
+	// Reorder the mesh for the post-transform cache (tools/meshReport prints the gains)
+	registeredMesh.optimizationStats = optimizeMesh(registeredMesh.vertexData, MESH_VERTEX_STRIDE, registeredMesh.indices, sortForOverdraw);
+
+	// Bounds for culling and picking (empty meshes get empty bounds)
+	registeredMesh.boundsMin = glm::vec3(FLT_MAX);
+	registeredMesh.boundsMax = glm::vec3(-FLT_MAX);
+	for(unsigned int i = 0; i < registeredMesh.vertexData.size(); i += MESH_VERTEX_STRIDE)
+	{
+		const glm::vec3 position(registeredMesh.vertexData[i], registeredMesh.vertexData[i + 1], registeredMesh.vertexData[i + 2]);
+		registeredMesh.boundsMin = glm::min(registeredMesh.boundsMin, position);
+		registeredMesh.boundsMax = glm::max(registeredMesh.boundsMax, position);
+	}
+
+	if(meshRenderBackend) meshRenderBackend->createMesh(meshID, registeredMesh);
+	return meshID;
+}
+
+void setMeshRenderBackend(RenderBackend *backend)
+{
+	meshRenderBackend = backend;
+	for(unsigned int meshID = 0; backend && meshID < meshes.size(); meshID++)
+	{
+		backend->createMesh(meshID, meshes[meshID]);
+	}
+}
+
+const Mesh &getMesh(const int meshID)
+{
+	return meshes[meshID];
+}
+
+int getMeshCount()
+{
+	return meshes.size();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "meshOptimizer.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+struct RenderBackend;
+
+// Number of floats in an interleaved (xyzrgba) vertex
+#define MESH_VERTEX_STRIDE 7
+
+// Mesh structure. The CPU copy of the vertex and index data is kept after the mesh is created on the render backend.
+struct Mesh
+{
+	std::vector<float> vertexData; // Interleaved xyzrgba vertex data
+	std::vector<unsigned int> indices; // Triangle list indices
+	glm::vec3 boundsMin, boundsMax; // Model space bounds of the vertices (set by registerMesh())
+	MeshOptimizationStats optimizationStats; // Gains of the vertex cache optimization (set by registerMesh())
+};
+
+// Optimizes the mesh for the vertex cache (and overdraw if 'sortForOverdraw' is set), adds it to the mesh registry
+// and creates it on the render backend (if one is set). Returns the ID of the registered mesh.
+int registerMesh(const Mesh &mesh, const bool sortForOverdraw);
+
+// Sets the render backend that registered meshes are created on, and creates the meshes registered so far on it.
+// Without a backend (0, the default) meshes only live in the registry, e.g. for the software rasterizer.
+void setMeshRenderBackend(RenderBackend *backend);
+
+// Returns the registered mesh with ID 'meshID'
+const Mesh &getMesh(const int meshID);
+
+// Returns the number of registered meshes
+int getMeshCount();
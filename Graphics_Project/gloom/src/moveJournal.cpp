@@ -0,0 +1,92 @@
+#include "moveJournal.hpp"
+
+#include <algorithm>
+
+PackedMove packMove(const TileMove &move, const Shape shape)
+{
+	const unsigned int from = move.fromY * BOARD_WIDTH + move.fromX;
+	const unsigned int to = move.toY * BOARD_WIDTH + move.toX;
+	return (PackedMove) (from | (to << 6) | ((unsigned int) shape << 12));
+}
+
+TileMove unpackMove(const PackedMove packed)
+{
+	const unsigned int from = packed & 63;
+	const unsigned int to = (packed >> 6) & 63;
+
+	TileMove move;
+	move.fromX = from % BOARD_WIDTH;
+	move.fromY = from / BOARD_WIDTH;
+	move.toX = to % BOARD_WIDTH;
+	move.toY = to / BOARD_WIDTH;
+	return move;
+}
+
+Shape getPackedMoveShape(const PackedMove packed)
+{
+	return (Shape) ((packed >> 12) & 7);
+}
+
+MoveJournal createMoveJournal(const BoardState &initialState)
+{
+	MoveJournal journal;
+	journal.position = 0;
+	journal.snapshotPositions.push_back(0);
+	journal.snapshots.push_back(initialState);
+	return journal;
+}
+
+void recordMove(MoveJournal &journal, const TileMove &move, const Shape shape, const BoardState &stateAfterMove)
+{
+	// A new move discards the moves that were undone, along with their snapshots
+	journal.moves.resize(journal.position);
+	while(journal.snapshotPositions.back() > journal.position)
+	{
+		journal.snapshotPositions.pop_back();
+		journal.snapshots.pop_back();
+	}
+
+	journal.moves.push_back(packMove(move, shape));
+	journal.position++;
+
+	// Snapshot the board every MOVE_JOURNAL_SNAPSHOT_INTERVAL moves
+	if(journal.position % MOVE_JOURNAL_SNAPSHOT_INTERVAL == 0)
+	{
+		journal.snapshotPositions.push_back(journal.position);
+		journal.snapshots.push_back(stateAfterMove);
+	}
+}
+
+bool undoMove(MoveJournal &journal, TileMove &move)
+{
+	if(journal.position == 0) return false;
+
+	// The reverse of the last applied move
+	const TileMove applied = unpackMove(journal.moves[--journal.position]);
+	move.fromX = applied.toX;
+	move.fromY = applied.toY;
+	move.toX = applied.fromX;
+	move.toY = applied.fromY;
+	return true;
+}
+
+bool redoMove(MoveJournal &journal, TileMove &move)
+{
+	if(journal.position >= journal.moves.size()) return false;
+	move = unpackMove(journal.moves[journal.position++]);
+	return true;
+}
+
+void getJournalState(const MoveJournal &journal, unsigned int position, BoardState &state)
+{
+	position = std::min(position, (unsigned int) journal.moves.size());
+
+	// Find the last snapshot at or before 'position', and replay the moves after it
+	const unsigned int snapshot = std::upper_bound(journal.snapshotPositions.begin(), journal.snapshotPositions.end(), position) - journal.snapshotPositions.begin() - 1;
+	state = journal.snapshots[snapshot];
+	for(unsigned int i = journal.snapshotPositions[snapshot]; i < position; i++)
+	{
+		const TileMove move = unpackMove(journal.moves[i]);
+		moveTileShape(state, move.fromX, move.fromY, move.toX, move.toY);
+	}
+}
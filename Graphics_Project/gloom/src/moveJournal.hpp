@@ -0,0 +1,45 @@
+#pragma once
+
+#include "boardState.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+// Append-only history of board moves with O(1) undo and redo. Every move is packed into 16 bits, and the board is
+// snapshotted every MOVE_JOURNAL_SNAPSHOT_INTERVAL moves so that any point in the history can be reconstructed by
+// a binary search for the closest snapshot followed by at most that many moves.
+
+// Moves between board snapshots
+#define MOVE_JOURNAL_SNAPSHOT_INTERVAL 64
+
+// A move packed as source tile (bits 0-5), destination tile (bits 6-11) and shape (bits 12-14)
+typedef uint16_t PackedMove;
+
+// Move journal
+struct MoveJournal
+{
+	std::vector<PackedMove> moves; // Every move, including the undone ones that can be redone
+	unsigned int position; // Number of moves currently applied (moves[position] is the next redo)
+	std::vector<unsigned int> snapshotPositions; // Move index of every snapshot (ascending)
+	std::vector<BoardState> snapshots; // Board after snapshotPositions[i] moves
+};
+
+// Packs and unpacks a move of 'shape'
+PackedMove packMove(const TileMove &move, const Shape shape);
+TileMove unpackMove(const PackedMove packed);
+Shape getPackedMoveShape(const PackedMove packed);
+
+// Creates a journal starting at 'initialState'
+MoveJournal createMoveJournal(const BoardState &initialState);
+
+// Records 'move' of 'shape', which turned the board into 'stateAfterMove'. Undone moves are discarded.
+void recordMove(MoveJournal &journal, const TileMove &move, const Shape shape, const BoardState &stateAfterMove);
+
+// Steps back one move and writes the move that reverts it to 'move'. Returns false if there is nothing to undo.
+bool undoMove(MoveJournal &journal, TileMove &move);
+
+// Steps forward one undone move and writes it to 'move'. Returns false if there is nothing to redo.
+bool redoMove(MoveJournal &journal, TileMove &move);
+
+// Writes the board after the first 'position' moves to 'state' (clamped to the recorded moves), without changing the journal
+void getJournalState(const MoveJournal &journal, unsigned int position, BoardState &state);
@@ -0,0 +1,210 @@
+#include "picking.hpp"
+
+#include <algorithm>
+#include <cfloat>
+
+PickBounds createEmptyBounds()
+{
+	PickBounds bounds;
+	bounds.min = glm::vec3(FLT_MAX);
+	bounds.max = glm::vec3(-FLT_MAX);
+	return bounds;
+}
+
+// Grows 'bounds' to include 'other'
+static inline void growBounds(PickBounds &bounds, const PickBounds &other)
+{
+	bounds.min = glm::min(bounds.min, other.min);
+	bounds.max = glm::max(bounds.max, other.max);
+}
+
+PickBounds transformBounds(const PickBounds &bounds, const glm::mat4 &matrix)
+{
+	if(bounds.min.x > bounds.max.x) return bounds;
+
+	// Transform the center and the extents (Arvo's method)
+	const glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+	const glm::vec3 extents = (bounds.max - bounds.min) * 0.5f;
+	const glm::vec3 newCenter = glm::vec3(matrix * glm::vec4(center, 1.0f));
+	glm::vec3 newExtents(0.0f);
+	for(int i = 0; i < 3; i++)
+	{
+		newExtents += glm::abs(glm::vec3(matrix[i])) * extents[i];
+	}
+
+	PickBounds result;
+	result.min = newCenter - newExtents;
+	result.max = newCenter + newExtents;
+	return result;
+}
+
+// Builds the subtree of node 'nodeIndex' over items [first, first + count)
+static void buildBVHNode(BVH &bvh, const unsigned int nodeIndex, const unsigned int first, const unsigned int count)
+{
+	PickBounds bounds = createEmptyBounds();
+	PickBounds centroidBounds = createEmptyBounds();
+	for(unsigned int i = first; i < first + count; i++)
+	{
+		const PickBounds &itemBounds = bvh.bounds[bvh.items[i]];
+		growBounds(bounds, itemBounds);
+		const glm::vec3 centroid = (itemBounds.min + itemBounds.max) * 0.5f;
+		centroidBounds.min = glm::min(centroidBounds.min, centroid);
+		centroidBounds.max = glm::max(centroidBounds.max, centroid);
+	}
+	bvh.nodes[nodeIndex].bounds = bounds;
+
+	// Make a leaf if there are few items left, or if they can't be separated
+	const glm::vec3 size = centroidBounds.max - centroidBounds.min;
+	const int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+	if(count <= BVH_LEAF_SIZE || !(size[axis] > 0.0f))
+	{
+		bvh.nodes[nodeIndex].first = first;
+		bvh.nodes[nodeIndex].count = count;
+		for(unsigned int i = first; i < first + count; i++) bvh.itemLeaves[bvh.items[i]] = nodeIndex;
+		return;
+	}
+
+	// Split at the median centroid of the longest axis
+	const unsigned int half = count / 2;
+	const std::vector<PickBounds> &itemBounds = bvh.bounds;
+	std::nth_element(bvh.items.begin() + first, bvh.items.begin() + first + half, bvh.items.begin() + first + count,
+		[&](const unsigned int a, const unsigned int b)
+		{
+			return itemBounds[a].min[axis] + itemBounds[a].max[axis] < itemBounds[b].min[axis] + itemBounds[b].max[axis];
+		});
+
+	const unsigned int left = bvh.nodes.size();
+	bvh.nodes[nodeIndex].first = left;
+	bvh.nodes[nodeIndex].count = 0;
+	bvh.nodes.resize(left + 2);
+	bvh.parents.resize(left + 2, nodeIndex);
+	buildBVHNode(bvh, left, first, half);
+	buildBVHNode(bvh, left + 1, first + half, count - half);
+}
+
+void buildBVH(BVH &bvh, const std::vector<PickBounds> &bounds)
+{
+	bvh.bounds = bounds;
+	bvh.items.resize(bounds.size());
+	for(unsigned int i = 0; i < bounds.size(); i++) bvh.items[i] = i;
+
+	bvh.itemLeaves.resize(bounds.size());
+	bvh.nodes.clear();
+	bvh.nodes.reserve(bounds.size() * 2 / BVH_LEAF_SIZE + 1);
+	bvh.nodes.resize(1);
+	bvh.parents.assign(1, 0);
+	buildBVHNode(bvh, 0, 0, bounds.size());
+}
+
+// Recomputes the bounds of node 'nodeIndex' from its items or children. Returns false if they didn't change.
+static bool refitBVHNode(BVH &bvh, const unsigned int nodeIndex)
+{
+	BVHNode &node = bvh.nodes[nodeIndex];
+	PickBounds bounds = createEmptyBounds();
+	if(node.count > 0)
+	{
+		for(unsigned int i = node.first; i < node.first + node.count; i++) growBounds(bounds, bvh.bounds[bvh.items[i]]);
+	}
+	else
+	{
+		bounds = bvh.nodes[node.first].bounds;
+		growBounds(bounds, bvh.nodes[node.first + 1].bounds);
+	}
+
+	if(bounds.min == node.bounds.min && bounds.max == node.bounds.max) return false;
+	node.bounds = bounds;
+	return true;
+}
+
+void updateBVHItem(BVH &bvh, const unsigned int item, const PickBounds &bounds)
+{
+	bvh.bounds[item] = bounds;
+
+	// Refit from the item's leaf up, until a node's bounds stay the same (then its ancestors do too)
+	unsigned int nodeIndex = bvh.itemLeaves[item];
+	while(refitBVHNode(bvh, nodeIndex) && nodeIndex != 0)
+	{
+		nodeIndex = bvh.parents[nodeIndex];
+	}
+}
+
+// Slab test. Returns the distance to the entry point, or FLT_MAX if the box is missed or further away than 'maxDistance'.
+static inline float intersectBounds(const PickBounds &bounds, const glm::vec3 &origin, const glm::vec3 &inverseDirection, const float maxDistance)
+{
+	if(bounds.min.x > bounds.max.x) return FLT_MAX;
+	const glm::vec3 t0 = (bounds.min - origin) * inverseDirection;
+	const glm::vec3 t1 = (bounds.max - origin) * inverseDirection;
+	const glm::vec3 tNear = glm::min(t0, t1);
+	const glm::vec3 tFar = glm::max(t0, t1);
+	const float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+	return entry <= exit ? entry : FLT_MAX;
+}
+
+int pickBVH(const BVH &bvh, const PickRay &ray, float *distance)
+{
+	if(bvh.nodes.empty()) return -1;
+
+	const glm::vec3 inverseDirection = 1.0f / ray.direction;
+	float closest = FLT_MAX;
+	int closestItem = -1;
+
+	// Depth-first traversal, visiting the nearer child first so that farther subtrees can be skipped
+	unsigned int stack[64];
+	int stackSize = 0;
+	if(intersectBounds(bvh.nodes[0].bounds, ray.origin, inverseDirection, closest) != FLT_MAX) stack[stackSize++] = 0;
+	while(stackSize > 0)
+	{
+		const BVHNode &node = bvh.nodes[stack[--stackSize]];
+		if(node.count > 0)
+		{
+			for(unsigned int i = node.first; i < node.first + node.count; i++)
+			{
+				const float t = intersectBounds(bvh.bounds[bvh.items[i]], ray.origin, inverseDirection, closest);
+				if(t < closest)
+				{
+					closest = t;
+					closestItem = bvh.items[i];
+				}
+			}
+			continue;
+		}
+
+		const float tLeft = intersectBounds(bvh.nodes[node.first].bounds, ray.origin, inverseDirection, closest);
+		const float tRight = intersectBounds(bvh.nodes[node.first + 1].bounds, ray.origin, inverseDirection, closest);
+		if(tLeft <= tRight)
+		{
+			if(tRight != FLT_MAX) stack[stackSize++] = node.first + 1;
+			if(tLeft != FLT_MAX) stack[stackSize++] = node.first;
+		}
+		else
+		{
+			if(tLeft != FLT_MAX) stack[stackSize++] = node.first;
+			stack[stackSize++] = node.first + 1;
+		}
+	}
+
+	if(distance) *distance = closest;
+	return closestItem;
+}
+
+PickRay createPickRay(const glm::mat4 &inverseViewProjection, const glm::vec2 &ndc)
+{
+	// Unproject the point on the near and the far plane
+	const glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+	const glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+
+	PickRay ray;
+	ray.origin = glm::vec3(nearPoint) / nearPoint.w;
+	ray.direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - ray.origin);
+	return ray;
+}
+
+PickRay transformPickRay(const PickRay &ray, const glm::mat4 &matrix)
+{
+	// The direction isn't normalized, so distances stay comparable between spaces
+	PickRay result;
+	result.origin = glm::vec3(matrix * glm::vec4(ray.origin, 1.0f));
+	result.direction = glm::vec3(matrix * glm::vec4(ray.direction, 0.0f));
+	return result;
+}
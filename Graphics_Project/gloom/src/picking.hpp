@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Ray picking against axis-aligned bounding boxes, accelerated by a bounding volume hierarchy.
+// The library doesn't use OpenGL, so it can be used (and tested) without a context.
+
+// Most items in a BVH leaf
+#define BVH_LEAF_SIZE 4
+
+// Axis-aligned bounding box. A box with min > max is empty and is never hit.
+struct PickBounds
+{
+	glm::vec3 min, max;
+};
+
+// Pick ray
+struct PickRay
+{
+	glm::vec3 origin;
+	glm::vec3 direction;
+};
+
+// BVH node. Leaves reference 'count' items starting at 'first' in BVH::items, inner nodes (count == 0)
+// have their children at 'first' and 'first + 1'.
+struct BVHNode
+{
+	PickBounds bounds;
+	unsigned int first;
+	unsigned int count;
+};
+
+// Bounding volume hierarchy over a list of item bounds
+struct BVH
+{
+	std::vector<BVHNode> nodes; // nodes[0] is the root
+	std::vector<unsigned int> items; // Item indices, grouped by leaf
+	std::vector<PickBounds> bounds; // Bounds of every item
+	std::vector<unsigned int> parents; // Parent of every node (the root is its own parent)
+	std::vector<unsigned int> itemLeaves; // Leaf node of every item
+};
+
+// Returns an empty box
+PickBounds createEmptyBounds();
+
+// Returns the bounds of 'bounds' transformed by 'matrix'
+PickBounds transformBounds(const PickBounds &bounds, const glm::mat4 &matrix);
+
+// Builds the BVH over 'bounds' by splitting at the median of the longest axis
+void buildBVH(BVH &bvh, const std::vector<PickBounds> &bounds);
+
+// Changes the bounds of item 'item' and refits the nodes on the path from its leaf to the root, in O(depth).
+// The tree is not rebuilt, so many large changes can make it less efficient.
+void updateBVHItem(BVH &bvh, const unsigned int item, const PickBounds &bounds);
+
+// Returns the index of the closest item hit by 'ray' and writes the distance along the ray to 'distance',
+// or returns -1 if nothing is hit
+int pickBVH(const BVH &bvh, const PickRay &ray, float *distance = 0);
+
+// Creates the ray through the point 'ndc' (normalized device coordinates) from the inverse of a view-projection matrix
+PickRay createPickRay(const glm::mat4 &inverseViewProjection, const glm::vec2 &ndc);
+
+// Transforms a ray by 'matrix' (e.g. the inverse of a model matrix, to pick in model space)
+PickRay transformPickRay(const PickRay &ray, const glm::mat4 &matrix);
@@ -1,17 +1,32 @@
 // Local headers
 #include "program.hpp"
 #include "sceneGraph.hpp"
+#include "boardState.hpp"
+#include "boardScene.hpp"
+#include "boardSolver.hpp"
 #include "shapes.hpp"
+#include "mesh.hpp"
+#include "material.hpp"
+#include "timestep.hpp"
+#include "animation.hpp"
+#include "inputRecorder.hpp"
+#include "moveJournal.hpp"
+#include "picking.hpp"
+#include "drawInstance.hpp"
+#include "drawList.hpp"
+#include "shadowCascades.hpp"
+#include "jobSystem.hpp"
+#include "glRenderBackend.hpp"
+#include "recordingRenderBackend.hpp"
 #include "gloom/gloom.hpp"
-#include "gloom/shader.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include <sstream>
+#include <cstring>
+#include <deque>
 #include <string>
-#include <fstream>
 #include <utility>
 
 // Enum of keyboard input actions
@@ -32,62 +47,38 @@ bool actionState[ACTION_COUNT];
 // Value storing the previous cursor position
 glm::vec2 previousCursorPos(0.0f);
 
-// Camera movement and rotation speed constants
-const float moveSpeed = 0.05f;
+// Input events received since the last simulation tick, and the log they are recorded to or replayed from
+std::vector<InputEvent> pendingInputEvents;
+InputLog inputLog = createInputLog();
+bool replayingInput = false;
+
+// Number of simulation ticks run so far
+uint32_t simulationTick = 0;
+
+// Camera movement (units per second) and rotation speed constants
+const float moveSpeed = 3.0f;
 const float rotationSpeed = 0.1f;
 
+// Seconds between the starts of the moves of a solution (see playSolution())
+const float solutionMoveStagger = 0.25f;
+
+// Simulation tick rate, and the maximum render frame rate (0 = uncapped)
+const double simulationTickRate = 60.0;
+const double maxFrameRate = 0.0;
+
 // Camera struct
 struct
 {
 	glm::vec3 position; // Camera position
+	glm::vec3 previousPosition; // Camera position at the previous simulation tick
 	float pitch, yaw;   // Camera orientation (pitch and yaw)
 } camera;
 
-// Sets up the initial model transformation for the nodes in the scene
-void initTransformationMatrix(SceneNode *node)
-{
-	if(node)
-	{
-		// Create model matrix for this node
-		node->currentTransformationMatrix = glm::mat4();
-		node->currentTransformationMatrix = glm::rotate(node->currentTransformationMatrix, node->rotationX, glm::vec3(1.0f, 0.0f, 0.0f));	// Apply model rotation
-		node->currentTransformationMatrix = glm::rotate(node->currentTransformationMatrix, node->rotationY, glm::vec3(0.0f, 1.0f, 0.0f));
-		node->currentTransformationMatrix = glm::rotate(node->currentTransformationMatrix, node->rotationZ, glm::vec3(0.0f, 0.0f, 1.0f));
-		node->currentTransformationMatrix = glm::translate(node->currentTransformationMatrix, glm::vec3(node->x, node->y, node->z));		// Apply model translation
-		node->currentTransformationMatrix = glm::scale(node->currentTransformationMatrix, glm::vec3(node->scaleFactor));					// Apply model scale
-
-		// Init transformation matrix of the children
-		for(SceneNode *child : node->children)
-		{
-			initTransformationMatrix(child);
-		}
-	}
-}
-
-// Get shape type by shape name
-const Shape getShapeByName(const std::string &name)
-{
-	if(name == "NONE") return SHAPE_NONE;
-	if(name == "TRIANGLE") return TRIANGLE;
-	if(name == "PARALLELOGRAM") return PARALLELOGRAM;
-	if(name == "ARROW") return ARROW;
-	if(name == "HEXAGON_WHITE") return HEXAGON_WHITE;
-	if(name == "HEXAGON_BLACK") return HEXAGON_BLACK;
-	if(name == "STAR") return STAR;
-	if(name == "CAKE") return CAKE;
-	printf("Invalid shape 's'\n", name.c_str());
-	return SHAPE_NONE;
-}
-
-// Tile structure
-struct Tile
-{
-	Shape shape; // Shape type of the tile
-	SceneNode *node; // SceneNode of the tile
-};
+// Render-independent board state
+BoardState boardState;
 
-// Create a tile-grid representation of the board
-Tile board[BOARD_HEIGHT][BOARD_WIDTH];
+// SceneNodes of the shapes on the board (0 for empty tiles)
+SceneNode *tileNodes[BOARD_HEIGHT][BOARD_WIDTH];
 
 // Currently selected shape position
 int selectedShapeX = 0;
@@ -103,12 +94,46 @@ SceneNode *moveMarkerNode = 0;
 int moveMarkerX = 0;
 int moveMarkerY = 0;
 
-// Animation variables
-bool animateMovement = false; // Flag indicating wether or not we are currently animating
-glm::vec3 animationFromPosition; // From position
-glm::vec3 animationToPosition; // To position
-float animationTime = 0.0f; // Current animation time
-SceneNode *animationNode = 0; // Current animation scene node
+// Shape movement animation constants
+const float moveDuration = 1.0f;
+const Easing moveEasing = EASE_IN_OUT;
+
+// The shape movement animations
+TweenPool tweens = createTweenPool(BOARD_WIDTH * BOARD_HEIGHT);
+
+// History of the moves made on the board
+MoveJournal moveJournal;
+
+// Moves of a batch (see moveShapes()) that haven't started yet, the seconds between their starts, and the seconds
+// until the next one may start
+std::deque<TileMove> queuedMoves;
+float queuedMoveStagger = 0.0f;
+float queuedMoveDelay = 0.0f;
+
+// Picking BVH over the board in board space. Item y * BOARD_WIDTH + x is tile [x, y], and item
+// BOARD_TILE_COUNT + y * BOARD_WIDTH + x is the shape on that tile (empty if there is none).
+BVH pickingBVH;
+
+// GPU picking. When enabled, an ID pass is drawn every frame and the ID under the cursor is read back
+// asynchronously. IDs are the picking BVH items plus one, so 0 means nothing.
+bool gpuPicking = false;
+uint32_t hoveredPickId = 0;
+
+// The board node, and the projection matrix used for rendering and picking (and its near and far plane)
+SceneNode *boardNode = 0;
+glm::mat4 projectionMatrix;
+const float nearPlane = 1.0f;
+const float farPlane = 100.0f;
+
+// Shadow cascades of the light, which shines down onto the board at an angle
+ShadowCascades shadowCascades = createShadowCascades(glm::vec3(0.3f, -1.0f, -0.5f));
+
+// Moves the move marker by 'offset' (in board space)
+void translateMoveMarker(const glm::vec3 &offset)
+{
+	moveMarkerNode->currentTransformationMatrix = glm::translate(offset) * moveMarkerNode->currentTransformationMatrix;
+	moveMarkerNode->dirty = true;
+}
 
 // If no shape is selected, we change the currently selected shape
 // If a shape is selected, we move the destination marker
@@ -117,46 +142,7 @@ void moveSelection(const int dx, const int dy)
 	if(!shapeSelected)
 	{
 		// No shape is selected, find the next shape in the given direction [dx, dy]
-		const int startX = selectedShapeX;
-		const int startY = selectedShapeY;
-		do
-		{
-			// If we go outside the right edge, jump one step down
-			if(selectedShapeX + dx >= BOARD_WIDTH)
-			{
-				selectedShapeY = (selectedShapeY + 1) % BOARD_HEIGHT;
-				selectedShapeX = 0;
-			}
-			else if(selectedShapeX + dx < 0)
-			{
-				selectedShapeY = (selectedShapeY - 1) % BOARD_HEIGHT;
-				selectedShapeX = BOARD_WIDTH - 1;
-			}
-			else
-			{
-				selectedShapeX += dx;
-			}
-
-			// If we go outside the bottom edge, jump one step to the right
-			if(selectedShapeY + dy >= BOARD_HEIGHT)
-			{
-				selectedShapeX = (selectedShapeX + 1) % BOARD_WIDTH;
-				selectedShapeY = 0;
-			}
-			else if(selectedShapeY + dy < 0)
-			{
-				selectedShapeX = (selectedShapeX - 1) % BOARD_WIDTH;
-				selectedShapeY = BOARD_HEIGHT - 1;
-			}
-			else
-			{
-				selectedShapeY += dy;
-			}
-
-			// If we're back to where we started, break
-			if(selectedShapeX == startX && selectedShapeY == startY) break;
-		}
-		while(board[selectedShapeY][selectedShapeX].shape == SHAPE_NONE);
+		findNextOccupiedTile(boardState, selectedShapeX, selectedShapeY, dx, dy);
 	}
 	else
 	{
@@ -167,31 +153,172 @@ void moveSelection(const int dx, const int dy)
 		// Update the destination marker transformation matrix, while making sure it wraps around the edges
 		if(moveMarkerX >= BOARD_WIDTH)
 		{
-			moveMarkerNode->currentTransformationMatrix = glm::translate(glm::vec3(-BOARD_WIDTH + 1, 0.0f, 0.0f)) * moveMarkerNode->currentTransformationMatrix;
+			translateMoveMarker(glm::vec3(-BOARD_WIDTH + 1, 0.0f, 0.0f));
 			moveMarkerX = 0;
 		}
 		else if(moveMarkerX < 0)
 		{
-			moveMarkerNode->currentTransformationMatrix = glm::translate(glm::vec3(BOARD_WIDTH - 1, 0.0f, 0.0f)) * moveMarkerNode->currentTransformationMatrix;
+			translateMoveMarker(glm::vec3(BOARD_WIDTH - 1, 0.0f, 0.0f));
 			moveMarkerX = BOARD_WIDTH - 1;
 		}
 		else if(moveMarkerY >= BOARD_HEIGHT)
 		{
-			moveMarkerNode->currentTransformationMatrix = glm::translate(glm::vec3(0.0f, -BOARD_HEIGHT + 1, 0.0f)) * moveMarkerNode->currentTransformationMatrix;
+			translateMoveMarker(glm::vec3(0.0f, -BOARD_HEIGHT + 1, 0.0f));
 			moveMarkerY = 0;
 		}
 		else if(moveMarkerY < 0)
 		{
-			moveMarkerNode->currentTransformationMatrix = glm::translate(glm::vec3(0.0f, BOARD_HEIGHT - 1, 0.0f)) * moveMarkerNode->currentTransformationMatrix;
+			translateMoveMarker(glm::vec3(0.0f, BOARD_HEIGHT - 1, 0.0f));
 			moveMarkerY = BOARD_HEIGHT - 1;
 		}
 		else
 		{
-			moveMarkerNode->currentTransformationMatrix = glm::translate(glm::vec3(dx, dy, 0.0f)) * moveMarkerNode->currentTransformationMatrix;
+			translateMoveMarker(glm::vec3(dx, dy, 0.0f));
 		}
 	}
 }
 
+// Moves the destination marker to tile [x, y]
+void setMoveMarker(const int x, const int y)
+{
+	translateMoveMarker(glm::vec3(x - moveMarkerX, y - moveMarkerY, 0.0f));
+	moveMarkerX = x;
+	moveMarkerY = y;
+}
+
+// Returns the bounds of a mesh in model space
+PickBounds getMeshBounds(const int meshID)
+{
+	const Mesh &mesh = getMesh(meshID);
+	PickBounds bounds;
+	bounds.min = mesh.boundsMin;
+	bounds.max = mesh.boundsMax;
+	return bounds;
+}
+
+// Returns the board space bounds of the shape on tile [x, y]. The bounds are placed where the shape will come
+// to rest, so picking doesn't depend on how far the animations have come.
+PickBounds getShapePickBounds(const int x, const int y)
+{
+	const SceneNode *node = tileNodes[y][x];
+	if(!node) return createEmptyBounds();
+	const glm::mat4 matrix = glm::translate(glm::vec3(x + 0.5f, y + 0.5f, node->z)) * glm::scale(glm::vec3(node->scaleFactor));
+	return transformBounds(getMeshBounds(node->meshID), matrix);
+}
+
+// Builds the picking BVH over the tiles and shapes of the board
+void createPickingBVH()
+{
+	const PickBounds boardBounds = getMeshBounds(boardNode->meshID);
+	std::vector<PickBounds> bounds(BOARD_TILE_COUNT * 2);
+	for(int y = 0; y < BOARD_HEIGHT; y++)
+	{
+		for(int x = 0; x < BOARD_WIDTH; x++)
+		{
+			PickBounds &tile = bounds[y * BOARD_WIDTH + x];
+			tile.min = glm::vec3(x, y, boardBounds.min.z);
+			tile.max = glm::vec3(x + 1, y + 1, boardBounds.max.z);
+			bounds[BOARD_TILE_COUNT + y * BOARD_WIDTH + x] = getShapePickBounds(x, y);
+		}
+	}
+	buildBVH(pickingBVH, bounds);
+}
+
+// Animates the shape on tile [fromX, fromY] to the empty tile [toX, toY], and swaps the tiles
+void animateShape(const int fromX, const int fromY, const int toX, const int toY)
+{
+	// Setup animation
+	addTween(tweens, tileNodes[fromY][fromX], fromX + 0.5f, fromY + 0.5f, toX + 0.5f, toY + 0.5f, moveDuration, moveEasing);
+
+	// Swap source and destination tiles
+	moveTileShape(boardState, fromX, fromY, toX, toY);
+	std::swap(tileNodes[toY][toX], tileNodes[fromY][fromX]);
+
+	// Move the shape's picking bounds to the destination tile
+	updateBVHItem(pickingBVH, BOARD_TILE_COUNT + fromY * BOARD_WIDTH + fromX, getShapePickBounds(fromX, fromY));
+	updateBVHItem(pickingBVH, BOARD_TILE_COUNT + toY * BOARD_WIDTH + toX, getShapePickBounds(toX, toY));
+}
+
+// Moves the shape on tile [fromX, fromY] to the empty tile [toX, toY] and records the move, so it can be undone
+void moveShape(const int fromX, const int fromY, const int toX, const int toY)
+{
+	const Shape shape = getTileShape(boardState, fromX, fromY);
+	animateShape(fromX, fromY, toX, toY);
+
+	const TileMove move = { fromX, fromY, toX, toY };
+	recordMove(moveJournal, move, shape, boardState);
+}
+
+// Undoes (or redoes) the last move, and puts the selection on the shape that moved.
+// Not allowed while a shape is selected, since the destination marker would be left behind.
+void stepMoveHistory(const bool redo)
+{
+	TileMove move;
+	if(shapeSelected || !(redo ? redoMove(moveJournal, move) : undoMove(moveJournal, move))) return;
+
+	animateShape(move.fromX, move.fromY, move.toX, move.toY);
+	selectedShapeX = move.toX;
+	selectedShapeY = move.toY;
+}
+
+// Queues a batch of moves (e.g. solver output), started in order by startQueuedMoves(). Every move starts at least
+// 'stagger' seconds after the previous one, so the moves of different shapes animate concurrently.
+void moveShapes(const std::vector<TileMove> &moves, const float stagger)
+{
+	if(queuedMoves.empty()) queuedMoveDelay = 0.0f;
+	queuedMoves.insert(queuedMoves.end(), moves.begin(), moves.end());
+	queuedMoveStagger = stagger;
+}
+
+// Starts the queued moves that are due, in order. A move also waits until its shape has stopped moving, since a
+// batch often moves a shape twice (out of the way, then to its place) and its second move has to start where the
+// first one ends. Moves that became invalid are dropped.
+void startQueuedMoves(const float dt)
+{
+	queuedMoveDelay -= dt;
+	while(!queuedMoves.empty() && queuedMoveDelay <= 0.0f)
+	{
+		const TileMove move = queuedMoves.front();
+		if(!isTileOccupied(boardState, move.fromX, move.fromY) || isTileOccupied(boardState, move.toX, move.toY))
+		{
+			queuedMoves.pop_front();
+			continue;
+		}
+		if(isTweening(tweens, tileNodes[move.fromY][move.fromX]))
+		{
+			queuedMoveDelay = 0.0f; // Start it as soon as the shape arrives, without catching up on the waiting time
+			break;
+		}
+
+		moveShape(move.fromX, move.fromY, move.toX, move.toY);
+		queuedMoves.pop_front();
+		queuedMoveDelay += queuedMoveStagger;
+	}
+}
+
+// Solves the board into the board in file 'targetPath' and plays the solution with moveShapes().
+// The moves don't go through the input events, so a recording has to be replayed with the same --solve option.
+void playSolution(const std::string &targetPath)
+{
+	BoardState target;
+	std::string error;
+	if(!loadBoardState(targetPath, target, &error))
+	{
+		fprintf(stderr, "Invalid board '%s': %s\n", targetPath.c_str(), error.c_str());
+		return;
+	}
+
+	std::vector<TileMove> moves;
+	SolverStats stats;
+	if(!solveBoard(boardState, target, moves, &stats))
+	{
+		fprintf(stderr, "Could not solve the board into '%s'\n", targetPath.c_str());
+		return;
+	}
+	printf("Solved into '%s' in %u moves (%.3f s)\n", targetPath.c_str(), (unsigned int) moves.size(), stats.seconds);
+	moveShapes(moves, solutionMoveStagger);
+}
+
 // If no shape is selected, this function selects the currently 'hovered' shape.
 // If a shape is selected, this function sets up the animation that will move the shape to the destination tile.
 void selectShape()
@@ -199,10 +326,10 @@ void selectShape()
 	if(!shapeSelected)
 	{
 		// If there is a shape on this position, mark it as selected
-		if(board[selectedShapeY][selectedShapeX].node)
+		if(isTileOccupied(boardState, selectedShapeX, selectedShapeY))
 		{
 			shapeSelected = true;
-			moveMarkerNode->currentTransformationMatrix = glm::translate(glm::vec3(selectedShapeX, selectedShapeY, -0.002f)) * moveMarkerNode->currentTransformationMatrix; // Show move marker
+			translateMoveMarker(glm::vec3(selectedShapeX, selectedShapeY, -0.002f)); // Show move marker
 			moveMarkerX = selectedShapeX;
 			moveMarkerY = selectedShapeY;
 		}
@@ -216,26 +343,18 @@ void selectShape()
 			shapeSelected = false;
 
 			// Hide marker node
-			moveMarkerNode->currentTransformationMatrix = glm::translate(glm::vec3(-moveMarkerX, -moveMarkerY, 0.002f)) * moveMarkerNode->currentTransformationMatrix;
+			translateMoveMarker(glm::vec3(-moveMarkerX, -moveMarkerY, 0.002f));
 		}
-		else if(!board[moveMarkerY][moveMarkerX].node) // If this tile is empty, setup animation variables for movement
+		else if(!isTileOccupied(boardState, moveMarkerX, moveMarkerY)) // If this tile is empty, move the shape there
 		{
 			// Un-select current shape
 			shapeSelected = false;
 
 			// Hide marker node
-			moveMarkerNode->currentTransformationMatrix = glm::translate(glm::vec3(-moveMarkerX, -moveMarkerY, 0.002f)) * moveMarkerNode->currentTransformationMatrix;
+			translateMoveMarker(glm::vec3(-moveMarkerX, -moveMarkerY, 0.002f));
 
-			// Setup animation
-			animateMovement = true;
-			animationFromPosition = glm::vec3(selectedShapeX, selectedShapeY, 0.0f);
-			animationToPosition = glm::vec3(moveMarkerX, moveMarkerY, 0.0f);
-			animationTime = 0.0f;
-			animationNode = board[selectedShapeY][selectedShapeX].node;
-
-			// Swap source and destination tiles
-			std::swap(board[moveMarkerY][moveMarkerX].shape, board[selectedShapeY][selectedShapeX].shape);
-			std::swap(board[moveMarkerY][moveMarkerX].node, board[selectedShapeY][selectedShapeX].node);
+			// Animate the shape to the destination and swap source and destination tiles
+			moveShape(selectedShapeX, selectedShapeY, moveMarkerX, moveMarkerY);
 
 			// Set selected shape to destination
 			selectedShapeX = moveMarkerX;
@@ -244,215 +363,392 @@ void selectShape()
 	}
 }
 
-// Creates the board using input file 'filepath' and returns the root node (the board)
+// Creates the board using input file 'filepath' and returns the root node (the board), or 0 if the file isn't a valid board
 SceneNode *createScene(const std::string &filepath)
 {
-	std::ifstream file(filepath);
-	std::string line;
-	if(getline(file, line))
+	// Load the board. A malformed file leaves the board cleared and no scene is created.
+	std::string error;
+	if(!loadBoardState(filepath, boardState, &error))
 	{
-		// Create board
-		SceneNode *boardNode = createSceneNode();
-		boardNode->vertexArrayObjectID = createBoard(line == "BLUE");
-		boardNode->z = -0.5f; boardNode->x = -4.0f; boardNode->y = -2.5f; // Center node
-		boardNode->rotationX = PI * 0.5f;
-
-		// Create move marker
-		moveMarkerNode = createSceneNode();
-		moveMarkerNode->vertexArrayObjectID = createMoveMarker();
-		moveMarkerNode->z = 0.001f;
-		addChild(boardNode, moveMarkerNode);
-
-		// Read file line by line, and create shapes at the correct position
-		int y = 0;
-		while(getline(file, line))
-		{
-			std::istringstream ss(line);
-			std::string shapeName;
+		fprintf(stderr, "Invalid board '%s': %s\n", filepath.c_str(), error.c_str());
+		return 0;
+	}
 
-			int x = 0;
-			while(ss >> shapeName)
-			{
-				const Shape shape = getShapeByName(shapeName);
-				if(shape != SHAPE_NONE)
-				{
-					// Create shape node
-					SceneNode *shapeNode = createSceneNode();
-					shapeNode->vertexArrayObjectID = createShape(shape);
-					shapeNode->z = -0.250001f;
-					shapeNode->x = x + 0.5f;
-					shapeNode->y = y + 0.5f;
-					shapeNode->scaleFactor = 0.75f;
-
-					// Setup board values
-					board[y][x].shape = shape;
-					board[y][x].node = shapeNode;
-
-					// Add child
-					addChild(boardNode, shapeNode);
-				}
-				else
-				{
-					// Setup board values
-					board[y][x].shape = SHAPE_NONE;
-					board[y][x].node = 0;
-				}
-				x++;
-			}
-			y++;
-		}
+	// Create board, move marker and shapes
+	BoardScene scene;
+	createBoardScene(boardState, scene);
+	boardNode = scene.boardNode;
+	moveMarkerNode = scene.moveMarkerNode;
+	memcpy(tileNodes, scene.tileNodes, sizeof(tileNodes));
+
+	// Start the move history at the loaded board
+	moveJournal = createMoveJournal(boardState);
+
+	// Setup picking
+	createPickingBVH();
+
+	// This will make sure a shape is selected from the start
+	moveSelection(1, 0);
+
+	// Return root node
+	return boardNode;
+}
+
+// Calculates the camera's forward, right and up vector from the yaw and pitch
+void getCameraAxes(glm::vec3 &fwd, glm::vec3 &right, glm::vec3 &up)
+{
+	computeCameraAxes(camera.pitch, camera.yaw, fwd, right, up);
+}
+
+// Returns the view-projection matrix of the camera at 'cameraPosition'
+glm::mat4 getViewProjectionMatrix(const glm::vec3 &cameraPosition)
+{
+	return getCameraViewProjectionMatrix(projectionMatrix, cameraPosition, camera.pitch, camera.yaw);
+}
 
-		// Init transformation matrices
-		initTransformationMatrix(boardNode);
+// Advances the camera by one simulation tick
+void updateCamera(const float dt)
+{
+	// Remember where the camera was, so we can interpolate between the last two ticks
+	camera.previousPosition = camera.position;
+
+	// Move the camera relative to the direction it is facing
+	glm::vec3 fwd, right, up;
+	getCameraAxes(fwd, right, up);
+	camera.position += right * float((actionState[MOVE_RIGHT] - actionState[MOVE_LEFT]) * moveSpeed * dt);
+	camera.position += up * float((actionState[MOVE_UP] - actionState[MOVE_DOWN]) * moveSpeed * dt);
+	camera.position += fwd * float((actionState[MOVE_BACKWARD] - actionState[MOVE_FORWARD]) * moveSpeed * dt);
+}
 
-		// This will make sure a shape is selected from the start
-		moveSelection(1, 0);
+// Applies a key event to the game state
+void handleKeyEvent(const int key, const int action)
+{
+	// Update action states based on key input
+	if(key == GLFW_KEY_A) actionState[MOVE_LEFT] = action != GLFW_RELEASE;
+	else if(key == GLFW_KEY_D) actionState[MOVE_RIGHT] = action != GLFW_RELEASE;
+	else if(key == GLFW_KEY_SPACE) actionState[MOVE_UP] = action != GLFW_RELEASE;
+	else if(key == GLFW_KEY_LEFT_SHIFT) actionState[MOVE_DOWN] = action != GLFW_RELEASE;
+	else if(key == GLFW_KEY_W) actionState[MOVE_FORWARD] = action != GLFW_RELEASE;
+	else if(key == GLFW_KEY_S) actionState[MOVE_BACKWARD] = action != GLFW_RELEASE;
 
-		// Return root node
-		return boardNode;
+	// Handle shape selection and movement (shapes that are still moving can be selected and moved again)
+	if(action == GLFW_PRESS)
+	{
+		if(key == GLFW_KEY_UP) moveSelection(0, -1);
+		else if(key == GLFW_KEY_DOWN) moveSelection(0, 1);
+		else if(key == GLFW_KEY_LEFT) moveSelection(-1, 0);
+		else if(key == GLFW_KEY_RIGHT) moveSelection(1, 0);
+		else if(key == GLFW_KEY_ENTER) selectShape();
+		else if(key == GLFW_KEY_Z) stepMoveHistory(false); // Undo
+		else if(key == GLFW_KEY_Y) stepMoveHistory(true); // Redo
 	}
+}
 
-	return 0;
+// Applies a cursor movement event to the camera
+void handleCursorPosEvent(const double x, const double y)
+{
+	// Apply mouse movement camera controls
+	glm::vec2 cursorPos(x, y);
+	camera.yaw -= (previousCursorPos.x - cursorPos.x) * rotationSpeed;
+	camera.pitch -= (previousCursorPos.y - cursorPos.y) * rotationSpeed;
+	previousCursorPos = cursorPos;
 }
 
-// Updates the scene recursively
-void updateAnimation(const float dt)
+// Returns the index of the tile under the point 'ndc' (normalized device coordinates), or -1 if there is none.
+// Shapes are picked too (they can stick out of their tile), and return the tile they stand on.
+int pickTile(const glm::vec2 &ndc)
 {
-	// If there is a node that needs animating
-	if(animateMovement)
+	// Cast the ray from the simulated camera, in board space
+	const glm::mat4 inverseViewProjection = glm::inverse(getViewProjectionMatrix(camera.position) * boardNode->currentTransformationMatrix);
+	const int item = pickBVH(pickingBVH, createPickRay(inverseViewProjection, ndc));
+	return item < 0 ? -1 : item % BOARD_TILE_COUNT;
+}
+
+// Returns the picking ID of a node (0 for nodes that can't be picked)
+uint32_t getPickId(const SceneNode *node)
+{
+	if(node == boardNode) return 1;
+	for(int tile = 0; tile < BOARD_TILE_COUNT; tile++)
 	{
-		// Interpolate the position of the shape from start position to end position over 1 second
-		animationTime += dt;
-		glm::vec3 pos = glm::mix(animationFromPosition, animationToPosition, glm::clamp(animationTime, 0.0f, 1.0f));
-		animationNode->x = pos.x + 0.5f;
-		animationNode->y = pos.y + 0.5f;
-		initTransformationMatrix(animationNode); // Update transformation matrix
-		animateMovement = animationTime < 1.0f;
+		if(tileNodes[tile / BOARD_WIDTH][tile % BOARD_WIDTH] == node) return 1 + BOARD_TILE_COUNT + tile;
 	}
+	return 0;
+}
+
+// Returns the node with picking ID 'id' (0 for tiles and empty space)
+SceneNode *getPickedNode(const uint32_t id)
+{
+	if(id <= BOARD_TILE_COUNT || id > 2 * BOARD_TILE_COUNT) return 0;
+	const int tile = (id - 1) % BOARD_TILE_COUNT;
+	return tileNodes[tile / BOARD_WIDTH][tile % BOARD_WIDTH];
 }
 
-// Draws the scene recursively
-void drawScene(SceneNode *node, std::stack<glm::mat4> *matrixStack)
+// Applies a mouse button event. A left click on a shape selects it, and a left click on a tile while a shape is
+// selected moves the shape there (clicking the selected shape again un-selects it).
+void handleMouseButtonEvent(const int button, const int action, const glm::vec2 &ndc, const int pickedTile)
 {
-	if(node)
+	if(button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS) return;
+
+	const int tile = pickedTile >= 0 ? pickedTile : pickTile(ndc);
+	if(tile < 0) return;
+	const int x = tile % BOARD_WIDTH;
+	const int y = tile / BOARD_WIDTH;
+
+	if(!shapeSelected)
+	{
+		if(!isTileOccupied(boardState, x, y)) return;
+		selectedShapeX = x;
+		selectedShapeY = y;
+	}
+	else
 	{
-		// Apply the model transformation matrix to the topmost matrix on the stack
-		glm::mat4 modelViewProjection = peekMatrix(matrixStack) * node->currentTransformationMatrix;
+		setMoveMarker(x, y);
+	}
+	selectShape();
+}
 
-		// Feed the mvp and model matrix to our shader program
-		glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(modelViewProjection));
-		glUniform1ui(1, board[selectedShapeY][selectedShapeX].node == node); // True if this shape is 'hovered'
+// Applies an input event to the game state
+void handleInputEvent(const InputEvent &event)
+{
+	if(event.type == INPUT_KEY) handleKeyEvent(event.key, event.action);
+	else if(event.type == INPUT_CURSOR_POS) handleCursorPosEvent(event.x, event.y);
+	else handleMouseButtonEvent(event.key, event.action, glm::vec2(event.x, event.y), event.pickedTile);
+}
 
-		// Draw scene node
-		glBindVertexArray(node->vertexArrayObjectID);
-		glDrawElements(GL_TRIANGLES, BOARD_HEIGHT * BOARD_WIDTH * 2 * 24, GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
+// Applies the input events of simulation tick 'tick', either the ones received from GLFW or the replayed ones
+void processInputEvents(const uint32_t tick)
+{
+	InputEvent event;
+	if(replayingInput)
+	{
+		while(nextReplayEvent(inputLog, tick, event))
+		{
+			handleInputEvent(event);
+		}
+	}
+	else
+	{
+		for(InputEvent &event : pendingInputEvents)
+		{
+			event.tick = tick;
+			recordInputEvent(inputLog, event);
+			handleInputEvent(event);
+		}
+		pendingInputEvents.clear();
+	}
+}
 
-		// Push current matrix on stack
-		pushMatrix(matrixStack, modelViewProjection);
+// Instances of the scene drawn this frame
+std::vector<DrawInstance> drawInstances;
 
-		// Draw children
-		for(SceneNode *child : node->children)
+// Collects the instances of the scene into 'drawInstances' and sets their selection and picking inputs.
+// The dirty flags of the scene are cleared, the instances keep track of which nodes moved.
+void collectSceneInstances(SceneNode *root, const glm::mat4 &viewProjectionMatrix)
+{
+	drawInstances.clear();
+	collectDrawInstances(root, viewProjectionMatrix, drawInstances);
+	clearDirtyFlags(root);
+	const SceneNode *hoveredNode = gpuPicking ? getPickedNode(hoveredPickId) : 0;
+	parallelFor(drawInstances.size(), DRAW_LIST_JOB_SIZE, [hoveredNode](unsigned int begin, unsigned int end)
+	{
+		for(unsigned int i = begin; i < end; i++)
 		{
-			drawScene(child, matrixStack);
+			// True if this shape is 'hovered', by the selection or (with GPU picking) by the cursor
+			DrawInstance &instance = drawInstances[i];
+			instance.selected = tileNodes[selectedShapeY][selectedShapeX] == instance.node || (hoveredNode && hoveredNode == instance.node);
+			instance.pickId = getPickId(instance.node);
+			instance.pickColumns = instance.node == boardNode ? BOARD_WIDTH : 0; // The board writes one ID per tile
 		}
+	});
+}
+
+// The backend the frames are submitted to
+RenderBackend *renderBackend = 0;
+
+// Draw lists of the frame: every instance, and the instances that can be picked (not the move marker)
+std::vector<DrawCommand> drawCommands;
+std::vector<DrawCommand> pickingCommands;
+std::vector<DrawCommand> shadowCommands;
+std::vector<DrawCommand> sortScratch;
+DrawListBuilder drawListBuilder;
+
+// Hands the instances of the frame to the render backend and draws them, as seen through 'viewProjectionMatrix'.
+// The picking pass draws picking IDs instead of colours, and starts reading back the ID at pixel [pickX, pickY].
+void drawScene(const std::vector<DrawInstance> &instances, const glm::mat4 &viewProjectionMatrix, const bool pickingPass, const int pickX, const int pickY)
+{
+	// Find the shadow cascades that have to be drawn again, usually none, or the ones an animating shape is in
+	const glm::mat4 inverseViewProjection = glm::inverse(viewProjectionMatrix);
+	const unsigned int shadowPasses = updateShadowCascades(shadowCascades, inverseViewProjection, nearPlane, farPlane, instances.data(), instances.size());
+	if(shadowPasses)
+	{
+		buildShadowDrawList(instances.data(), instances.size(), shadowCommands);
+		sortDrawList(shadowCommands, sortScratch);
+	}
+
+	// Build the draw lists in parallel and sort the draws by state and depth, so the backend only changes the state
+	// that differs between them
+	buildDrawLists(drawListBuilder, instances.data(), instances.size(), drawCommands, pickingPass ? &pickingCommands : 0);
+	sortDrawList(drawCommands, sortScratch);
+	if(pickingPass) sortDrawList(pickingCommands, sortScratch);
 
-		// Pop current matrix from stack
-		popMatrix(matrixStack);
+	renderBackend->updateInstances(instances.data(), instances.size());
+	renderBackend->beginFrame(glm::vec4(0.3f, 0.3f, 0.4f, 1.0f));
+	for(int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		if(shadowPasses & (1 << cascade))
+		{
+			renderBackend->submitShadowPass(cascade, shadowCascades.cascades[cascade].viewProjection, shadowCommands.data(), shadowCommands.size());
+		}
 	}
+	renderBackend->setShadowCascades(shadowCascades.cascades, inverseViewProjection);
+	renderBackend->submitDrawList(drawCommands.data(), drawCommands.size());
+	if(pickingPass)
+	{
+		renderBackend->submitPickingPass(pickingCommands.data(), pickingCommands.size(), pickX, pickY);
+	}
+	renderBackend->endFrame();
 }
 
-void runProgram(GLFWwindow* window)
+void runProgram(GLFWwindow* window, const ProgramOptions &options)
 {
+	// Load the input events to replay
+	if(!options.replayPath.empty())
+	{
+		if(!loadInputLog(inputLog, options.replayPath))
+		{
+			fprintf(stderr, "Could not load input log '%s'\n", options.replayPath.c_str());
+			return;
+		}
+		replayingInput = true;
+	}
+
     // Set GLFW callback mechanism(s)
     glfwSetKeyCallback(window, keyboardCallback);
 	glfwSetCursorPosCallback(window, cursorPosCallback); // Cursor movement callback added
+	glfwSetMouseButtonCallback(window, mouseButtonCallback);
 
 	// Set cursor input mode to GLFW_CURSOR_DISABLED (locks cursor to window)
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-    // Enable depth (Z) buffer (accept "closest" fragment)
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
-
-    // Configure miscellaneous OpenGL settings
-    glEnable(GL_CULL_FACE);
-
-    // Set default colour after clearing the colour buffer
-    glClearColor(0.3f, 0.3f, 0.4f, 1.0f);
+	// Create the render backend (it sets up the GL state and loads the shaders). Without rendering, frames are
+	// submitted to a null backend instead, so the scene logic runs the same way.
+	int framebufferWidth, framebufferHeight;
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+	renderBackend = options.render ? createGLRenderBackend(framebufferWidth, framebufferHeight) : createRecordingRenderBackend(false);
+	setMeshRenderBackend(renderBackend);
+	setMaterialRenderBackend(renderBackend);
 
 	// Create scene
 	SceneNode *root = createScene("../boards/EASY_01");
+	if(!root)
+	{
+		setMeshRenderBackend(0);
+		setMaterialRenderBackend(0);
+		delete renderBackend;
+		return;
+	}
 
-	// Load our shader
-	Gloom::Shader shader;
-	shader.attach("../gloom/shaders/simple.vert");
-	shader.attach("../gloom/shaders/simple.frag");
-	shader.link();
+	// Play the solution into the target board
+	if(!options.solveTarget.empty()) playSolution(options.solveTarget);
 
 	// Set initial camera position and orientation
 	camera.position.x = 0.0f;
 	camera.position.y = 4.0f;
 	camera.position.z = 7.0f;
+	camera.previousPosition = camera.position;
 	camera.pitch = 20.0f;
 	camera.yaw = 90.0f;
 
+	// Run the simulation at a fixed rate, independently of the render frame rate
+	FixedTimestep timestep = createFixedTimestep(simulationTickRate);
+	glfwSwapInterval(0);
+	getTimeDeltaSeconds();
+
 	// Calculate projection matrix
 	int width, height;
 	glfwGetWindowSize(window, &width, &height);
-	glm::mat4 projectionMatrix = glm::perspective(1.0f, (float) width / (float) height, 1.0f, 100.0f);
+	projectionMatrix = glm::perspective(1.0f, (float) width / (float) height, nearPlane, farPlane);
+
+	const double startTime = glfwGetTime();
 
     // Rendering Loop
     while (!glfwWindowShouldClose(window))
     {
-        // Clear colour and depth buffers
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// Update scene
-		updateAnimation(getTimeDeltaSeconds());
-
-		// Calculate the camera's forward, right and up vector from the yaw and pitch
-		glm::vec3 fwd;
-		fwd.x = cos(glm::radians(camera.pitch)) * cos(glm::radians(camera.yaw));
-		fwd.y = sin(glm::radians(camera.pitch));
-		fwd.z = cos(glm::radians(camera.pitch)) * sin(glm::radians(camera.yaw));
-		glm::vec3 right = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), fwd));
-		glm::vec3 up = glm::cross(fwd, right);
-
-		// Move the camera relative to the direction it is facing
-		camera.position += right * float((actionState[MOVE_RIGHT] - actionState[MOVE_LEFT]) * moveSpeed);
-		camera.position += up * float((actionState[MOVE_UP] - actionState[MOVE_DOWN]) * moveSpeed);
-		camera.position += fwd * float((actionState[MOVE_BACKWARD] - actionState[MOVE_FORWARD]) * moveSpeed);
-
-		glm::mat4 eyeSpaceMatrix(
-			right.x, up.x, fwd.x, 0.0f,
-			right.y, up.y, fwd.y, 0.0f,
-			right.z, up.z, fwd.z, 0.0f,
-			0.0f, 0.0f, 0.0f, 1.0f);
-
-		// Calcualte our projection matrix
-		glm::mat4 viewProjectionMatrix;
-		viewProjectionMatrix = eyeSpaceMatrix * viewProjectionMatrix;					// mvp = eyeSpaceMatrix
-		viewProjectionMatrix = glm::translate(viewProjectionMatrix, -camera.position);	// mvp = eyeSpaceMatrix * centerCameraMatrix
-		viewProjectionMatrix = projectionMatrix * viewProjectionMatrix;					// mvp = projectionMatrix * eyeSpaceMatrix * centerCameraMatrix
-
-		// Push our projection matrix onto the matrix stack
-		std::stack<glm::mat4> *matrixStack = createEmptyMatrixStack();
-		pushMatrix(matrixStack, viewProjectionMatrix);
+		// Update scene in fixed simulation ticks. A replay runs as fast as possible: one tick per frame, or as many
+		// ticks as allowed when we're not rendering.
+		const double replaySeconds = timestep.tickSeconds * (options.render ? 1 : timestep.maxTicksPerFrame);
+		advanceFixedTimestep(timestep, replayingInput ? replaySeconds : getTimeDeltaSeconds());
+		while(consumeTick(timestep))
+		{
+			processInputEvents(simulationTick++);
+			startQueuedMoves((float) timestep.tickSeconds);
+			updateTweens(tweens, (float) timestep.tickSeconds);
+			updateCamera((float) timestep.tickSeconds);
+		}
+
+		// Stop when the replay is done and every shape has arrived
+		if(replayingInput && isReplayFinished(inputLog) && queuedMoves.empty() && tweens.count == 0) break;
+
+		// Render the state between the last two simulation ticks
+		const float alpha = getInterpolationAlpha(timestep);
+		applyTweens(tweens, alpha);
+		const glm::vec3 cameraPosition = glm::mix(camera.previousPosition, camera.position, alpha);
+		const glm::mat4 viewProjectionMatrix = getViewProjectionMatrix(cameraPosition);
+
+		// With GPU picking, the picking pass reads back the ID under the cursor (or the center of the screen if the
+		// cursor is locked). The result arrives a frame or two later.
+		int pickX = framebufferWidth / 2, pickY = framebufferHeight / 2;
+		if(gpuPicking)
+		{
+			renderBackend->pollPickingResult(hoveredPickId);
+			if(glfwGetInputMode(window, GLFW_CURSOR) != GLFW_CURSOR_DISABLED)
+			{
+				double cursorX, cursorY;
+				glfwGetCursorPos(window, &cursorX, &cursorY);
+				pickX = (int) (cursorX / width * framebufferWidth);
+				pickY = (int) ((1.0 - cursorY / height) * framebufferHeight);
+			}
+		}
 
 		// Draw scene
-		shader.activate();
-		drawScene(root, matrixStack);
-		shader.deactivate();
+		collectSceneInstances(root, viewProjectionMatrix);
+		drawScene(drawInstances, viewProjectionMatrix, gpuPicking, pickX, pickY);
 
         // Handle other events
         glfwPollEvents();
 
-        // Flip buffers
-        glfwSwapBuffers(window);
+		// Flip buffers
+		if(options.render) glfwSwapBuffers(window);
+
+		// Throttle the loop (the simulation rate is unaffected), replays aren't throttled
+		if(!replayingInput) limitFrameRate(options.render ? maxFrameRate : simulationTickRate);
     }
 
-	shader.destroy();
+	// Report the session, the board hash identifies the final board state
+	const double seconds = glfwGetTime() - startTime;
+	printf("%u simulation ticks in %.3f s (%.0f ticks/s), final board hash %016llx\n",
+		simulationTick, seconds, seconds > 0.0 ? simulationTick / seconds : 0.0, (unsigned long long) boardState.hash);
+	const RenderStats renderStats = renderBackend->getStats();
+	if(renderStats.frames > 0)
+	{
+		printf("%llu frames, %.1f KB uploaded per frame (%.2f MB/s), %llu frames waited for the GPU\n", (unsigned long long) renderStats.frames,
+			renderStats.uploadBytes / 1024.0 / renderStats.frames, seconds > 0.0 ? renderStats.uploadBytes / (1024.0 * 1024.0) / seconds : 0.0,
+			(unsigned long long) renderStats.uploadWaits);
+		printf("%llu shadow cascades drawn, %llu reused from the cache\n", (unsigned long long) shadowCascades.renderedCascades,
+			(unsigned long long) shadowCascades.cachedCascades);
+	}
+
+	// Save the recorded input events
+	if(!options.recordPath.empty() && !replayingInput)
+	{
+		if(saveInputLog(inputLog, options.recordPath)) printf("Recorded %u input events to '%s'\n", (unsigned int) inputLog.events.size(), options.recordPath.c_str());
+		else fprintf(stderr, "Could not save input log '%s'\n", options.recordPath.c_str());
+	}
+
+	setMeshRenderBackend(0);
+	setMaterialRenderBackend(0);
+	delete renderBackend;
+	renderBackend = 0;
 }
 
 void keyboardCallback(GLFWwindow* window, int key, int scancode,
@@ -464,30 +760,63 @@ void keyboardCallback(GLFWwindow* window, int key, int scancode,
         glfwSetWindowShouldClose(window, GL_TRUE);
     }
 
-	// Update action states based on key input
-	if(key == GLFW_KEY_A) actionState[MOVE_LEFT] = action != GLFW_RELEASE;
-	else if(key == GLFW_KEY_D) actionState[MOVE_RIGHT] = action != GLFW_RELEASE;
-	else if(key == GLFW_KEY_SPACE) actionState[MOVE_UP] = action != GLFW_RELEASE;
-	else if(key == GLFW_KEY_LEFT_SHIFT) actionState[MOVE_DOWN] = action != GLFW_RELEASE;
-	else if(key == GLFW_KEY_W) actionState[MOVE_FORWARD] = action != GLFW_RELEASE;
-	else if(key == GLFW_KEY_S) actionState[MOVE_BACKWARD] = action != GLFW_RELEASE;
+	// Toggle GPU picking (a render setting, so it isn't recorded)
+	if(key == GLFW_KEY_P && action == GLFW_PRESS)
+	{
+		gpuPicking = !gpuPicking;
+		hoveredPickId = 0;
+		return;
+	}
 
-	// Handle shape selection and movement
-	if(action == GLFW_PRESS && !animateMovement)
+	// Queue the event, it is applied on the next simulation tick (live input is ignored while replaying)
+	if(!replayingInput && action != GLFW_REPEAT)
 	{
-		if(key == GLFW_KEY_UP) moveSelection(0, -1);
-		else if(key == GLFW_KEY_DOWN) moveSelection(0, 1);
-		else if(key == GLFW_KEY_LEFT) moveSelection(-1, 0);
-		else if(key == GLFW_KEY_RIGHT) moveSelection(1, 0);
-		else if(key == GLFW_KEY_ENTER) selectShape();
+		InputEvent event = {};
+		event.type = INPUT_KEY;
+		event.key = key;
+		event.action = action;
+		pendingInputEvents.push_back(event);
 	}
 }
 
 void cursorPosCallback(GLFWwindow* window, double x, double y)
 {
-	// Apply mouse movement camera controls
-	glm::vec2 cursorPos(x, y);
-	camera.yaw -= (previousCursorPos.x - cursorPos.x) * rotationSpeed;
-	camera.pitch -= (previousCursorPos.y - cursorPos.y) * rotationSpeed;
-	previousCursorPos = cursorPos;
+	// Queue the event, it is applied on the next simulation tick (live input is ignored while replaying)
+	if(!replayingInput)
+	{
+		InputEvent event = {};
+		event.type = INPUT_CURSOR_POS;
+		event.x = x;
+		event.y = y;
+		pendingInputEvents.push_back(event);
+	}
+}
+
+void mouseButtonCallback(GLFWwindow* window, int button, int action, int /*mods*/)
+{
+	// Queue the event along with the clicked point, it is applied on the next simulation tick
+	if(!replayingInput)
+	{
+		InputEvent event = {};
+		event.type = INPUT_MOUSE_BUTTON;
+		event.key = button;
+		event.action = action;
+		event.pickedTile = -1;
+
+		// With GPU picking, the tile under the cursor is already known
+		if(gpuPicking && hoveredPickId > 0) event.pickedTile = (hoveredPickId - 1) % BOARD_TILE_COUNT;
+
+		// The cursor is locked to the window for mouse look, so we pick through the center of the screen.
+		// With a visible cursor, we pick under the cursor.
+		if(glfwGetInputMode(window, GLFW_CURSOR) != GLFW_CURSOR_DISABLED)
+		{
+			double x, y;
+			int width, height;
+			glfwGetCursorPos(window, &x, &y);
+			glfwGetWindowSize(window, &width, &height);
+			event.x = x / width * 2.0 - 1.0;
+			event.y = 1.0 - y / height * 2.0;
+		}
+		pendingInputEvents.push_back(event);
+	}
 }
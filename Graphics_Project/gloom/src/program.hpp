@@ -7,12 +7,22 @@
 #include <glad/glad.h>
 #include <string>
 
+// Command line options of the program
+struct ProgramOptions
+{
+	std::string recordPath; // Write the input events to this file (if not empty)
+	std::string replayPath; // Replay the input events in this file as fast as possible (if not empty)
+	std::string solveTarget; // Solve the board into this board and play the moves (if not empty)
+	bool render; // Set to false to skip rendering
+};
+
 // Main OpenGL program
-void runProgram(GLFWwindow* window);
+void runProgram(GLFWwindow* window, const ProgramOptions &options);
 
 // GLFW callback mechanisms
 void keyboardCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void cursorPosCallback(GLFWwindow* window, double x, double y);
+void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 
 // Checks for whether an OpenGL error occurred. If one did,
 // it prints out the error type and ID
@@ -51,8 +61,4 @@ inline void printGLError() {
     }
 }
 
-// Constants
-#define BOARD_WIDTH 8
-#define BOARD_HEIGHT 5
-
 #endif
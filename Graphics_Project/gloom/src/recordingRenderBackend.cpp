@@ -0,0 +1,116 @@
+#include "recordingRenderBackend.hpp"
+
+// Counts (and records) a command
+static inline void addCommand(RecordingRenderBackend &backend, const RenderCommandType type, const uint32_t value)
+{
+	backend.commandCounts[type]++;
+	if(backend.recordCommands)
+	{
+		RenderCommand command;
+		command.type = type;
+		command.value = value;
+		backend.commands.push_back(command);
+	}
+}
+
+void RecordingRenderBackend::createMesh(const int meshID, const Mesh &)
+{
+	addCommand(*this, RENDER_COMMAND_CREATE_MESH, meshID);
+}
+
+void RecordingRenderBackend::createMaterial(const int materialID, const TextureLayer &)
+{
+	addCommand(*this, RENDER_COMMAND_CREATE_MATERIAL, materialID);
+}
+
+void RecordingRenderBackend::updateInstances(const DrawInstance *newInstances, const unsigned int count)
+{
+	// Copy the instances like a real backend would upload them
+	instances.assign(newInstances, newInstances + count);
+	instanceBytes += count * sizeof(DrawInstance);
+	addCommand(*this, RENDER_COMMAND_UPDATE_INSTANCES, count);
+}
+
+void RecordingRenderBackend::beginFrame(const glm::vec4 &)
+{
+	addCommand(*this, RENDER_COMMAND_BEGIN_FRAME, 0);
+}
+
+// Counts (and records) the mesh binds of a draw list like the GL backend makes them: one per run of draws with the
+// same mesh, which the GL backend draws as one instanced draw
+static void addMeshBinds(RecordingRenderBackend &backend, const DrawCommand *drawCommands, const unsigned int count, const RenderCommandType type)
+{
+	for(unsigned int i = 0; i < count; i++)
+	{
+		if(i == 0 || (getDrawStateChanges(drawCommands[i - 1].key, drawCommands[i].key) & DRAW_STATE_MESH))
+		{
+			addCommand(backend, RENDER_COMMAND_BIND_MESH, backend.instances[drawCommands[i].instance].meshID);
+		}
+		addCommand(backend, type, drawCommands[i].instance);
+	}
+}
+
+void RecordingRenderBackend::submitShadowPass(const int cascade, const glm::mat4 &, const DrawCommand *drawCommands, const unsigned int count)
+{
+	addCommand(*this, RENDER_COMMAND_SHADOW_PASS, cascade);
+	addMeshBinds(*this, drawCommands, count, RENDER_COMMAND_SHADOW_DRAW);
+}
+
+void RecordingRenderBackend::setShadowCascades(const ShadowCascade *, const glm::mat4 &)
+{
+}
+
+void RecordingRenderBackend::submitDrawList(const DrawCommand *drawCommands, const unsigned int count)
+{
+	addMeshBinds(*this, drawCommands, count, RENDER_COMMAND_DRAW);
+}
+
+bool RecordingRenderBackend::submitPickingPass(const DrawCommand *drawCommands, const unsigned int count, const int, const int)
+{
+	addMeshBinds(*this, drawCommands, count, RENDER_COMMAND_PICK);
+	return false;
+}
+
+bool RecordingRenderBackend::pollPickingResult(uint32_t &)
+{
+	return false;
+}
+
+void RecordingRenderBackend::endFrame()
+{
+	addCommand(*this, RENDER_COMMAND_END_FRAME, 0);
+}
+
+bool RecordingRenderBackend::readFrame(std::vector<uint32_t> &pixels, int &width, int &height)
+{
+	pixels.clear();
+	width = height = 0;
+	return false;
+}
+
+RenderStats RecordingRenderBackend::getStats() const
+{
+	RenderStats stats;
+	stats.frames = commandCounts[RENDER_COMMAND_END_FRAME];
+	stats.uploadBytes = instanceBytes;
+	stats.uploadWaits = 0;
+	return stats;
+}
+
+RecordingRenderBackend *createRecordingRenderBackend(const bool recordCommands)
+{
+	RecordingRenderBackend *backend = new RecordingRenderBackend();
+	backend->recordCommands = recordCommands;
+	resetRecordingRenderBackend(*backend);
+	return backend;
+}
+
+void resetRecordingRenderBackend(RecordingRenderBackend &backend)
+{
+	backend.commands.clear();
+	backend.instanceBytes = 0;
+	for(int type = 0; type < RENDER_COMMAND_TYPE_COUNT; type++)
+	{
+		backend.commandCounts[type] = 0;
+	}
+}
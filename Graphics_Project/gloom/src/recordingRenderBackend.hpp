@@ -0,0 +1,57 @@
+#pragma once
+
+#include "renderBackend.hpp"
+
+// Backend that draws nothing and needs no GL context. It counts the commands it receives and, if asked, records them,
+// so the scene logic can run in tests and the CPU cost of building and submitting frames can be measured in isolation.
+
+// Command types
+enum RenderCommandType
+{
+	RENDER_COMMAND_CREATE_MESH, // Value: mesh ID
+	RENDER_COMMAND_CREATE_MATERIAL, // Value: material ID
+	RENDER_COMMAND_UPDATE_INSTANCES, // Value: instance count
+	RENDER_COMMAND_BEGIN_FRAME, // Value: 0
+	RENDER_COMMAND_BIND_MESH, // Value: mesh ID (state change before a draw, see getDrawStateChanges())
+	RENDER_COMMAND_DRAW, // Value: instance index
+	RENDER_COMMAND_PICK, // Value: instance index
+	RENDER_COMMAND_SHADOW_PASS, // Value: cascade
+	RENDER_COMMAND_SHADOW_DRAW, // Value: instance index
+	RENDER_COMMAND_END_FRAME, // Value: 0
+	RENDER_COMMAND_TYPE_COUNT
+};
+
+// A recorded command
+struct RenderCommand
+{
+	RenderCommandType type;
+	uint32_t value;
+};
+
+struct RecordingRenderBackend : RenderBackend
+{
+	bool recordCommands; // Keep every command in 'commands', otherwise they are only counted
+	std::vector<RenderCommand> commands;
+	uint64_t commandCounts[RENDER_COMMAND_TYPE_COUNT]; // Commands received of every type
+	std::vector<DrawInstance> instances; // Instances of the current frame
+	uint64_t instanceBytes; // Bytes of instances copied
+
+	void createMesh(const int meshID, const Mesh &mesh);
+	void createMaterial(const int materialID, const TextureLayer &texture);
+	void updateInstances(const DrawInstance *newInstances, const unsigned int count);
+	void beginFrame(const glm::vec4 &clearColor);
+	void submitShadowPass(const int cascade, const glm::mat4 &lightViewProjection, const DrawCommand *drawCommands, const unsigned int count);
+	void setShadowCascades(const ShadowCascade *cascades, const glm::mat4 &inverseViewProjection);
+	void submitDrawList(const DrawCommand *drawCommands, const unsigned int count);
+	bool submitPickingPass(const DrawCommand *drawCommands, const unsigned int count, const int x, const int y);
+	bool pollPickingResult(uint32_t &id);
+	void endFrame();
+	bool readFrame(std::vector<uint32_t> &pixels, int &width, int &height);
+	RenderStats getStats() const;
+};
+
+// Creates a recording backend. With 'recordCommands' unset it only counts commands (a null backend).
+RecordingRenderBackend *createRecordingRenderBackend(const bool recordCommands);
+
+// Clears the recorded commands and the counts
+void resetRecordingRenderBackend(RecordingRenderBackend &backend);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "drawInstance.hpp"
+#include "drawList.hpp"
+#include "mesh.hpp"
+#include "shadowCascades.hpp"
+#include "textureLoader.hpp"
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <vector>
+
+// Interface between the scene logic and the graphics API. The scene registers meshes, hands the backend the instances
+// of every frame and submits draw lists that refer to them, so none of the scene code calls the graphics API itself.
+// Implementations: the OpenGL 4.4 backend (glRenderBackend.hpp) and a null backend that records the commands it
+// receives (recordingRenderBackend.hpp), which needs no GL context.
+
+// Counters of a backend since it was created
+struct RenderStats
+{
+	uint64_t frames;
+	uint64_t uploadBytes; // Per-frame data written for the GPU (instance data)
+	uint64_t uploadWaits; // Frames that had to wait for the GPU before writing their data
+};
+
+struct RenderBackend
+{
+	virtual ~RenderBackend() {}
+
+	// Creates the backend's copy of the registered mesh 'meshID' (see setMeshRenderBackend())
+	virtual void createMesh(const int meshID, const Mesh &mesh) = 0;
+
+	// Creates layer 'materialID' of the backend's material texture array (see setMaterialRenderBackend())
+	virtual void createMaterial(const int materialID, const TextureLayer &texture) = 0;
+
+	// Replaces the instances that the draw lists of this frame refer to
+	virtual void updateInstances(const DrawInstance *instances, const unsigned int count) = 0;
+
+	// Starts a frame by clearing the colour and depth buffers
+	virtual void beginFrame(const glm::vec4 &clearColor) = 0;
+
+	// Draws the shadow casters of 'commands' into the shadow map of cascade 'cascade', as seen through the cascade's
+	// 'lightViewProjection'. The shadow maps keep their contents between frames, so only the cascades that changed
+	// have to be drawn (see updateShadowCascades()). Call between beginFrame() and submitDrawList().
+	virtual void submitShadowPass(const int cascade, const glm::mat4 &lightViewProjection, const DrawCommand *commands, const unsigned int count) = 0;
+
+	// Sets the cascades that submitDrawList() reads the shadows from, and the inverse view-projection of the camera
+	virtual void setShadowCascades(const ShadowCascade *cascades, const glm::mat4 &inverseViewProjection) = 0;
+
+	// Draws the instances of 'commands' in order, like simple.vert and simple.frag. The commands should be sorted by key
+	// (see sortDrawList()), the backend only changes the state that differs between consecutive keys.
+	virtual void submitDrawList(const DrawCommand *commands, const unsigned int count) = 0;
+
+	// Draws the picking IDs of the instances of 'commands' (see id.frag), and starts reading back the ID at pixel [x, y]
+	// (from the bottom left). Returns false if the backend can't pick.
+	virtual bool submitPickingPass(const DrawCommand *commands, const unsigned int count, const int x, const int y) = 0;
+
+	// Writes the most recent picking ID that has been read back to 'id' and returns true, or returns false if none
+	// has arrived since the last call
+	virtual bool pollPickingResult(uint32_t &id) = 0;
+
+	// Ends the frame
+	virtual void endFrame() = 0;
+
+	// Reads back the colour buffer of the frame as RGBA8 pixels, bottom row first. Returns false if the backend
+	// has no colour buffer. Stalls until the frame is done, so it's meant for tests and offline frames.
+	virtual bool readFrame(std::vector<uint32_t> &pixels, int &width, int &height) = 0;
+
+	// Returns the counters of the backend
+	virtual RenderStats getStats() const = 0;
+};
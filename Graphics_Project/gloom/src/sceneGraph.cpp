@@ -1,4 +1,5 @@
 #include "sceneGraph.hpp"
+#include "jobSystem.hpp"
 
 // --- Matrix Stack related functions ---
 
@@ -50,7 +51,10 @@ SceneNode* createSceneNode() {
 	node->scaleFactor = 1.0;
 	node->rotationSpeedRadians = 0;
 	node->rotationDirection = glm::vec3(1, 0, 0);
-	node->vertexArrayObjectID = -1;
+	node->meshID = -1;
+	node->materialID = 0;
+	node->castsShadow = true;
+	node->dirty = true;
 	return node;
 }
 
@@ -59,6 +63,82 @@ void addChild(SceneNode* parent, SceneNode* child) {
 	parent->children.push_back(child);
 }
 
+// Number of nodes per transform update job
+#define TRANSFORM_JOB_SIZE 4096
+
+// Builds the model transformation of 'count' nodes at once using the batch transform kernel.
+// Large batches are split into ranges that are built in parallel on the job system; the function returns
+// when all matrices are written, so the caller (and the renderer) only ever sees finished matrices.
+void initTransformationMatrices(TransformBuilder &builder, SceneNode *const *nodes, const unsigned int count)
+{
+	TransformBatch &batch = builder.batch;
+	std::vector<glm::mat4> &matrices = builder.matrices;
+	if(batch.x.size() < count)
+	{
+		resizeTransformBatch(batch, count);
+		matrices.resize(count);
+	}
+
+	parallelFor(count, TRANSFORM_JOB_SIZE, [&](const unsigned int begin, const unsigned int end)
+	{
+		// Gather the rotation, translation and scale of the nodes
+		for(unsigned int i = begin; i < end; i++)
+		{
+			const SceneNode *node = nodes[i];
+			batch.rotationX[i] = node->rotationX;
+			batch.rotationY[i] = node->rotationY;
+			batch.rotationZ[i] = node->rotationZ;
+			batch.x[i] = node->x;
+			batch.y[i] = node->y;
+			batch.z[i] = node->z;
+			batch.scale[i] = node->scaleFactor;
+		}
+
+		// Build the matrices and write them back
+		buildTransformMatrices(batch, begin, end - begin, matrices.data() + begin);
+		for(unsigned int i = begin; i < end; i++)
+		{
+			nodes[i]->currentTransformationMatrix = matrices[i];
+			nodes[i]->dirty = true;
+		}
+	});
+}
+
+// Appends 'node' and all of its descendants to 'nodes'
+void flattenSceneGraph(SceneNode *node, std::vector<SceneNode*> &nodes)
+{
+	if(node)
+	{
+		nodes.push_back(node);
+		for(SceneNode *child : node->children)
+		{
+			flattenSceneGraph(child, nodes);
+		}
+	}
+}
+
+// Sets up the model transformation for 'node' and its descendants
+void initTransformationMatrix(SceneNode *node)
+{
+	std::vector<SceneNode*> nodes;
+	flattenSceneGraph(node, nodes);
+	TransformBuilder builder;
+	initTransformationMatrices(builder, nodes.data(), nodes.size());
+}
+
+// Clears the dirty flag of 'node' and its descendants
+void clearDirtyFlags(SceneNode *node)
+{
+	if(node)
+	{
+		node->dirty = false;
+		for(SceneNode *child : node->children)
+		{
+			clearDirtyFlags(child);
+		}
+	}
+}
+
 // Pretty prints the current values of a SceneNode instance to stdout
 void printNode(SceneNode* node) {
 	printf(
@@ -69,7 +149,7 @@ void printNode(SceneNode* node) {
 		"    Scale: %f\n"
 		"    Rotation Speed: %f\n"
 		"    Rotation Direction: (%f, %f, %f)\n"
-		"    VAO ID: %i\n"
+		"    Mesh ID: %i\n"
 		"}\n",
 		node->children.size(),
 		node->rotationX, node->rotationY, node->rotationZ,
@@ -77,7 +157,7 @@ void printNode(SceneNode* node) {
 		node->scaleFactor,
 		node->rotationSpeedRadians,
 		node->rotationDirection[0], node->rotationDirection[1], node->rotationDirection[2], 
-		node->vertexArrayObjectID);
+		node->meshID);
 }
 
 // --- Utility functions ---
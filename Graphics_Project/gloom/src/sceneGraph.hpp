@@ -1,5 +1,7 @@
 #pragma once
 
+#include "transformKernel.hpp"
+
 #include <glm/glm.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -54,12 +56,34 @@ typedef struct SceneNode {
 	// A transformation matrix representing the transformation of the node's location relative to its parent. This matrix is updated every frame.
 	glm::mat4 currentTransformationMatrix;
 
-	// The ID of the VAO containing the "appearance" of this SceneNode.
-	int vertexArrayObjectID;
+	// The ID of the registered mesh containing the "appearance" of this SceneNode (-1 if it has none).
+	int meshID;
+
+	// The ID of the material (texture) of the mesh, 0 for white (see material.hpp)
+	int materialID;
+
+	// Whether the mesh casts shadows (see shadowCascades.hpp)
+	bool castsShadow;
+
+	// Set when the transformation matrix changes (initTransformationMatrices() sets it, code that edits the matrix
+	// directly has to set it too), cleared by clearDirtyFlags() once the frame has been drawn. Lets the renderer
+	// find the nodes that moved, along with their children.
+	bool dirty;
 } SceneNode;
 
+// Buffers of initTransformationMatrices(), kept between calls so they don't have to be reallocated
+struct TransformBuilder
+{
+	TransformBatch batch;
+	std::vector<glm::mat4> matrices;
+};
+
 SceneNode* createSceneNode();
 void addChild(SceneNode* parent, SceneNode* child);
+void flattenSceneGraph(SceneNode *node, std::vector<SceneNode*> &nodes);
+void initTransformationMatrix(SceneNode *node);
+void initTransformationMatrices(TransformBuilder &builder, SceneNode *const *nodes, const unsigned int count);
+void clearDirtyFlags(SceneNode *node);
 void printNode(SceneNode* node);
 
 // Utility functions
@@ -0,0 +1,198 @@
+#include "shadowCascades.hpp"
+#include "mesh.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cfloat>
+#include <cmath>
+
+ShadowCascades createShadowCascades(const glm::vec3 &lightDirection)
+{
+	ShadowCascades shadows;
+	const glm::vec3 direction = glm::normalize(lightDirection);
+	const glm::vec3 up = fabsf(direction.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+	shadows.lightView = glm::lookAt(glm::vec3(0.0f), direction, up);
+	for(int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		shadows.cascades[cascade].viewProjection = glm::mat4(1.0f);
+		shadows.cascades[cascade].splitDepth = 0.0f;
+		shadows.cascades[cascade].valid = false;
+	}
+	shadows.updates = 0;
+	shadows.renderedCascades = 0;
+	shadows.cachedCascades = 0;
+	return shadows;
+}
+
+void invalidateShadowCascades(ShadowCascades &shadows)
+{
+	for(int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		shadows.cascades[cascade].valid = false;
+	}
+}
+
+// Returns the light-space projection of a cascade that covers the view depths [nearDepth, farDepth] of the camera.
+// 'nearCorners' and 'farCorners' are the world space corners of the camera's near and far plane, at 'nearPlane' and
+// 'farPlane'. The view depth is linear along the lines between them.
+static glm::mat4 fitCascade(const glm::mat4 &lightView, const glm::vec3 *nearCorners, const glm::vec3 *farCorners,
+	const float nearPlane, const float farPlane, const float nearDepth, const float farDepth)
+{
+	// Corners of the frustum slice, and their bounding sphere. The sphere doesn't change when the camera turns.
+	glm::vec3 corners[8];
+	glm::vec3 center(0.0f);
+	for(int i = 0; i < 4; i++)
+	{
+		corners[i] = glm::mix(nearCorners[i], farCorners[i], (nearDepth - nearPlane) / (farPlane - nearPlane));
+		corners[i + 4] = glm::mix(nearCorners[i], farCorners[i], (farDepth - nearPlane) / (farPlane - nearPlane));
+		center += corners[i] + corners[i + 4];
+	}
+	center /= 8.0f;
+	float radius = 0.0f;
+	for(int i = 0; i < 8; i++)
+	{
+		radius = glm::max(radius, glm::length(corners[i] - center));
+	}
+	radius = ceilf(radius * 16.0f) / 16.0f; // Rounded up, so rounding errors don't change it from frame to frame
+
+	// Snap the center to whole texels in light space, so the projection only changes when the camera has moved a texel
+	const float texelSize = 2.0f * radius / SHADOW_MAP_SIZE;
+	glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+	lightCenter = glm::floor(lightCenter / texelSize) * texelSize;
+
+	// The box reaches towards the light to include the casters between the light and the slice
+	return glm::ortho(lightCenter.x - radius, lightCenter.x + radius, lightCenter.y - radius, lightCenter.y + radius,
+		-lightCenter.z - radius - SHADOW_CASTER_DISTANCE, -lightCenter.z + radius) * lightView;
+}
+
+// Computes the world space bounds of an instance's mesh
+static void getInstanceBounds(const DrawInstance &instance, glm::vec3 &boundsMin, glm::vec3 &boundsMax)
+{
+	const Mesh &mesh = getMesh(instance.meshID);
+	boundsMin = glm::vec3(FLT_MAX);
+	boundsMax = glm::vec3(-FLT_MAX);
+	for(int corner = 0; corner < 8; corner++)
+	{
+		const glm::vec3 point((corner & 1) ? mesh.boundsMax.x : mesh.boundsMin.x, (corner & 2) ? mesh.boundsMax.y : mesh.boundsMin.y,
+		                      (corner & 4) ? mesh.boundsMax.z : mesh.boundsMin.z);
+		const glm::vec3 world = glm::vec3(instance.model * glm::vec4(point, 1.0f));
+		boundsMin = glm::min(boundsMin, world);
+		boundsMax = glm::max(boundsMax, world);
+	}
+}
+
+// Returns true if a caster with the given world space bounds can cast a shadow into the cascade seen through
+// 'viewProjection'. Casters between the light and the cascade's near plane count too, they are clamped to it.
+static bool isCasterInCascade(const glm::mat4 &viewProjection, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+	glm::vec3 clipMin(FLT_MAX), clipMax(-FLT_MAX);
+	for(int corner = 0; corner < 8; corner++)
+	{
+		const glm::vec3 point((corner & 1) ? boundsMax.x : boundsMin.x, (corner & 2) ? boundsMax.y : boundsMin.y, (corner & 4) ? boundsMax.z : boundsMin.z);
+		const glm::vec3 clip = glm::vec3(viewProjection * glm::vec4(point, 1.0f)); // Orthographic, so w is 1
+		clipMin = glm::min(clipMin, clip);
+		clipMax = glm::max(clipMax, clip);
+	}
+	return clipMax.x >= -1.0f && clipMin.x <= 1.0f && clipMax.y >= -1.0f && clipMin.y <= 1.0f && clipMin.z <= 1.0f;
+}
+
+// Adds the cascades (that aren't already in 'mask') which a caster with the given bounds casts shadows into to 'mask'
+static void addCasterCascades(const ShadowCascades &shadows, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, unsigned int &mask)
+{
+	for(int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		if(!(mask & (1 << cascade)) && isCasterInCascade(shadows.cascades[cascade].viewProjection, boundsMin, boundsMax))
+		{
+			mask |= 1 << cascade;
+		}
+	}
+}
+
+unsigned int updateShadowCascades(ShadowCascades &shadows, const glm::mat4 &inverseViewProjection, const float nearPlane,
+	const float farPlane, const DrawInstance *instances, const unsigned int count)
+{
+	const uint64_t update = ++shadows.updates;
+
+	// Corners of the camera's near and far plane in world space
+	glm::vec3 nearCorners[4], farCorners[4];
+	for(int i = 0; i < 4; i++)
+	{
+		const float x = (i & 1) ? 1.0f : -1.0f, y = (i & 2) ? 1.0f : -1.0f;
+		const glm::vec4 nearCorner = inverseViewProjection * glm::vec4(x, y, -1.0f, 1.0f);
+		const glm::vec4 farCorner = inverseViewProjection * glm::vec4(x, y, 1.0f, 1.0f);
+		nearCorners[i] = glm::vec3(nearCorner) / nearCorner.w;
+		farCorners[i] = glm::vec3(farCorner) / farCorner.w;
+	}
+
+	// Split the shadowed depth range between logarithmic and uniform splits, and fit the cascades. A cascade whose
+	// projection changed has to be rendered.
+	unsigned int mask = 0;
+	const float shadowDistance = glm::min(SHADOW_DISTANCE, farPlane);
+	float splitNear = nearPlane;
+	for(int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		const float p = (cascade + 1.0f) / SHADOW_CASCADE_COUNT;
+		const float logarithmicSplit = nearPlane * powf(shadowDistance / nearPlane, p);
+		const float uniformSplit = nearPlane + (shadowDistance - nearPlane) * p;
+		const float splitFar = SHADOW_SPLIT_LAMBDA * logarithmicSplit + (1.0f - SHADOW_SPLIT_LAMBDA) * uniformSplit;
+
+		ShadowCascade &shadowCascade = shadows.cascades[cascade];
+		const glm::mat4 viewProjection = fitCascade(shadows.lightView, nearCorners, farCorners, nearPlane, farPlane, splitNear, splitFar);
+		if(!shadowCascade.valid || viewProjection != shadowCascade.viewProjection) mask |= 1 << cascade;
+		shadowCascade.viewProjection = viewProjection;
+		shadowCascade.splitDepth = splitFar;
+		splitNear = splitFar;
+	}
+
+	// A caster that moved changes the cascades it was in and the cascades it is in now. Only the casters that are dirty
+	// (or new) have their bounds recomputed.
+	unsigned int casterCount = 0;
+	for(unsigned int i = 0; i < count; i++)
+	{
+		const DrawInstance &instance = instances[i];
+		if(!instance.castsShadow) continue;
+		casterCount++;
+
+		std::unordered_map<const SceneNode*, ShadowCaster>::iterator found = shadows.casters.find(instance.node);
+		if(found == shadows.casters.end())
+		{
+			ShadowCaster caster;
+			getInstanceBounds(instance, caster.boundsMin, caster.boundsMax);
+			addCasterCascades(shadows, caster.boundsMin, caster.boundsMax, mask);
+			found = shadows.casters.insert(std::make_pair(instance.node, caster)).first;
+		}
+		else if(instance.transformChanged)
+		{
+			ShadowCaster &caster = found->second;
+			addCasterCascades(shadows, caster.boundsMin, caster.boundsMax, mask);
+			getInstanceBounds(instance, caster.boundsMin, caster.boundsMax);
+			addCasterCascades(shadows, caster.boundsMin, caster.boundsMax, mask);
+		}
+		found->second.update = update;
+	}
+
+	// Casters that are gone leave the cascades they were in
+	if(shadows.casters.size() > casterCount)
+	{
+		for(std::unordered_map<const SceneNode*, ShadowCaster>::iterator it = shadows.casters.begin(); it != shadows.casters.end();)
+		{
+			if(it->second.update != update)
+			{
+				addCasterCascades(shadows, it->second.boundsMin, it->second.boundsMax, mask);
+				it = shadows.casters.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	for(int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		if(mask & (1 << cascade)) shadows.renderedCascades++;
+		else shadows.cachedCascades++;
+		shadows.cascades[cascade].valid = true;
+	}
+	return mask;
+}
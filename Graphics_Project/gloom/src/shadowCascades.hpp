@@ -0,0 +1,67 @@
+#pragma once
+
+#include "drawInstance.hpp"
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <unordered_map>
+
+// Cascaded shadow maps for a directional light. The view frustum up to SHADOW_DISTANCE is split into cascades that
+// cover increasing depth ranges, and each cascade has its own shadow map. The shadow maps are cached between frames:
+// a cascade is only re-rendered when its light-space projection changed (the camera moved far enough) or when one of
+// its casters moved. Moving casters are found through the scene's dirty flags (DrawInstance::transformChanged), so a
+// static board with one animating shape only re-renders the cascades that shape passes through.
+// Cascades are fitted to the bounding sphere of their frustum slice, so their size doesn't change when the camera
+// turns, and they are moved in whole shadow map texels, so the shadow edges don't shimmer and a camera that stands
+// still keeps its cascades.
+
+// Number of cascades (the same count is in simple.frag)
+#define SHADOW_CASCADE_COUNT 3
+
+// Width and height of the shadow map of a cascade (texels)
+#define SHADOW_MAP_SIZE 2048
+
+// View depth up to which shadows are drawn, and how far towards the light the cascades reach to catch casters
+// outside the view
+#define SHADOW_DISTANCE 30.0f
+#define SHADOW_CASTER_DISTANCE 20.0f
+
+// Blend between logarithmic (1) and uniform (0) cascade splits
+#define SHADOW_SPLIT_LAMBDA 0.75f
+
+struct ShadowCascade
+{
+	glm::mat4 viewProjection; // World to the cascade's clip space
+	float splitDepth; // View depth where the cascade ends
+	bool valid; // The cascade's shadow map holds its casters as seen through 'viewProjection'
+};
+
+// World space bounds of a shadow caster when it was last seen, and the update it was last seen in
+struct ShadowCaster
+{
+	glm::vec3 boundsMin, boundsMax;
+	uint64_t update;
+};
+
+struct ShadowCascades
+{
+	glm::mat4 lightView; // Rotation into light space (the light shines down -z)
+	ShadowCascade cascades[SHADOW_CASCADE_COUNT];
+	std::unordered_map<const SceneNode*, ShadowCaster> casters;
+	uint64_t updates; // Number of updates so far
+	uint64_t renderedCascades, cachedCascades; // Cascades that had to be rendered and that were reused, over all updates
+};
+
+// Creates the cascades of a directional light shining in 'lightDirection'. Every cascade starts out invalid.
+ShadowCascades createShadowCascades(const glm::vec3 &lightDirection);
+
+// Fits the cascades to the view frustum of the camera (its inverse view-projection matrix and the near and far plane
+// of its projection), and checks the casters among 'instances' that changed, appeared or disappeared since the last
+// update. Returns a mask with bit i set if cascade i has to be rendered. The caster bounds are only recomputed for
+// the instances whose transformation changed, and the returned cascades are assumed to be rendered before the next
+// update.
+unsigned int updateShadowCascades(ShadowCascades &shadows, const glm::mat4 &inverseViewProjection, const float nearPlane,
+	const float farPlane, const DrawInstance *instances, const unsigned int count);
+
+// Marks every cascade as invalid, so that all of them are rendered at the next update
+void invalidateShadowCascades(ShadowCascades &shadows);
@@ -1,15 +1,17 @@
 #include "shapes.hpp"
+#include "mesh.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-// Generate VAO using input vertices, colors and indices
-GLuint generateVertexArray(float *vertices, float *colors, unsigned int *indices, const unsigned int triangleCount)
+// Generate a mesh using input vertices, colors and indices and add it to the mesh registry
+int generateMesh(float *vertices, float *colors, unsigned int *indices, const unsigned int triangleCount)
 {
-	// Create continous (xyzrgba) interleaved vertex data pointer
+	// Create continous (xyzrgba) interleaved vertex data
 	const unsigned int vertexCount = triangleCount * 3;
-	const unsigned int vertexDataSize = (3 + 4) * vertexCount;
-	float *vertexData = new float[vertexDataSize];
+	Mesh mesh;
+	mesh.vertexData.resize(MESH_VERTEX_STRIDE * vertexCount);
+	float *vertexData = mesh.vertexData.data();
 	for(unsigned int i = 0; i < vertexCount; i++)
 	{
 		// Write xyz
@@ -24,41 +26,21 @@ GLuint generateVertexArray(float *vertices, float *colors, unsigned int *indices
 		vertexData[i * 7 + 6] = colors[i * 4 + 3];
 	}
 
-	// Generate and bind Vertex Array Object
-	GLuint vaoID, vboID, iboID;
-	glGenVertexArrays(1, &vaoID);
-	glBindVertexArray(vaoID);
+	// Copy the index data
+	mesh.indices.assign(indices, indices + vertexCount);
 
-	// Generate Vertex Buffer Object and upload the vertex data
-	glGenBuffers(1, &vboID);
-	glBindBuffer(GL_ARRAY_BUFFER, vboID);
-	glBufferData(GL_ARRAY_BUFFER, vertexDataSize * sizeof(float), vertexData, GL_STATIC_DRAW);
-
-	// Set and enable vertex attribute pointers for the VBO
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, (3 + 4) * sizeof(float), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, (3 + 4) * sizeof(float), (void*) (3 * sizeof(float)));
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-
-	// Generate Index Buffer Object and upload the index data
-	glGenBuffers(1, &iboID);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboID);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, vertexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
-
-	// Unbind VAO
-	glBindVertexArray(0);
-
-	// Return VAO id
-	return vaoID;
+	// Register mesh
+	return registerMesh(mesh, false);
 }
 
-// Extrude input triangles and generate a VAO for the extruded model
-GLuint generateExtrudedVertexArray(float *vertices, float *colors, unsigned int *indices, const unsigned int triangleCount, const float depth)
+// Extrude input triangles and generate a mesh for the extruded model
+int generateExtrudedMesh(float *vertices, float *colors, unsigned int *indices, const unsigned int triangleCount, const float depth)
 {
-	// Create continous (xyzrgba) interleaved vertex data pointer
+	// Create continous (xyzrgba) interleaved vertex data
 	const unsigned int vertexCount = triangleCount * 3;
-	const unsigned int vertexDataSize = (3 + 4) * vertexCount * 2;
-	float *vertexData = new float[vertexDataSize];
+	Mesh mesh;
+	mesh.vertexData.resize(MESH_VERTEX_STRIDE * vertexCount * 2);
+	float *vertexData = mesh.vertexData.data();
 	for(unsigned int i = 0; i < vertexCount; i++)
 	{
 		// Write xyz
@@ -85,8 +67,9 @@ GLuint generateExtrudedVertexArray(float *vertices, float *colors, unsigned int
 	}
 
 	// Reconstruct our index buffer
-	unsigned int *indexData = new unsigned int[triangleCount * 24]; // After extrusion, there will be 8 times as many triangles
-	for(int i = 0; i < triangleCount; i++)
+	mesh.indices.resize(triangleCount * 24); // After extrusion, there will be 8 times as many triangles
+	unsigned int *indexData = mesh.indices.data();
+	for(unsigned int i = 0; i < triangleCount; i++)
 	{
 		// Bottom
 		indexData[i * 24 + 0] = indices[i * 3 + 0] * 2;
@@ -132,36 +115,12 @@ GLuint generateExtrudedVertexArray(float *vertices, float *colors, unsigned int
 		}
 	}
 
-	// Generate and bind Vertex Array Object
-	GLuint vaoID, vboID, iboID;
-	glGenVertexArrays(1, &vaoID);
-	glBindVertexArray(vaoID);
-
-	// Generate Vertex Buffer Object and upload the vertex data
-	glGenBuffers(1, &vboID);
-	glBindBuffer(GL_ARRAY_BUFFER, vboID);
-	glBufferData(GL_ARRAY_BUFFER, vertexDataSize * sizeof(float), vertexData, GL_STATIC_DRAW);
-
-	// Set and enable vertex attribute pointers for the VBO
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, (3 + 4) * sizeof(float), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, (3 + 4) * sizeof(float), (void*) (3 * sizeof(float)));
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-
-	// Generate Index Buffer Object and upload the index data
-	glGenBuffers(1, &iboID);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboID);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, triangleCount * 24 * sizeof(unsigned int), indexData, GL_STATIC_DRAW);
-
-	// Unbind VAO
-	glBindVertexArray(0);
-
-	// Return VAO id
-	return vaoID;
+	// Register mesh (extruded shapes overlap themselves, so sort them for overdraw)
+	return registerMesh(mesh, true);
 }
 
 // Creates the model for 'shape' by extruding a 2D version of the shape
-GLuint createShape(const Shape shape)
+int createShape(const Shape shape)
 {
 	// Shape variables (set inside the switch-statement)
 	int triangleCount = 0;
@@ -424,8 +383,8 @@ GLuint createShape(const Shape shape)
 		break;
 	}
 
-	// If triangleCount == 0, it's not a valid shape. Return 0
-	if(triangleCount == 0) return 0;
+	// If triangleCount == 0, it's not a valid shape. Return -1
+	if(triangleCount == 0) return -1;
 
 	// Generate color and index buffers for the shape
 	float* colors = new float[triangleCount * 3 * 4];
@@ -446,20 +405,20 @@ GLuint createShape(const Shape shape)
 		indices[i] = i;
 	}
 
-	// Generate extruded vao
-	GLuint vaoID = generateExtrudedVertexArray(vertices, colors, indices, triangleCount, 0.25f);
+	// Generate extruded mesh
+	const int meshID = generateExtrudedMesh(vertices, colors, indices, triangleCount, 0.25f);
 
 	// Cleaning up after ourselves
 	delete[] vertices;
 	delete[] indices;
 	delete[] colors;
 
-	// Return vao
-	return vaoID;
+	// Return mesh
+	return meshID;
 }
 
 // Creates a red and blue checkerboard
-GLuint createBoard(const bool startWithBlue)
+int createBoard(const bool startWithBlue)
 {
 	const unsigned int triangleCount = BOARD_HEIGHT * BOARD_WIDTH * 2;
 
@@ -491,7 +450,8 @@ GLuint createBoard(const bool startWithBlue)
 				colors[i * 4 + 2] = b;
 				colors[i * 4 + 3] = 1.0;
 
-				indices[i] = i++;
+				indices[i] = i;
+				i++;
 
 				vertices[i * 3 + 0] = x;
 				vertices[i * 3 + 1] = y + 1;
@@ -502,7 +462,8 @@ GLuint createBoard(const bool startWithBlue)
 				colors[i * 4 + 2] = b;
 				colors[i * 4 + 3] = 1.0;
 
-				indices[i] = i++;
+				indices[i] = i;
+				i++;
 
 				vertices[i * 3 + 0] = x + 1;
 				vertices[i * 3 + 1] = y;
@@ -513,7 +474,8 @@ GLuint createBoard(const bool startWithBlue)
 				colors[i * 4 + 2] = b;
 				colors[i * 4 + 3] = 1.0;
 
-				indices[i] = i++;
+				indices[i] = i;
+				i++;
 			}
 
 			// Triangle 2
@@ -527,7 +489,8 @@ GLuint createBoard(const bool startWithBlue)
 				colors[i * 4 + 2] = b;
 				colors[i * 4 + 3] = 1.0;
 
-				indices[i] = i++;
+				indices[i] = i;
+				i++;
 
 				vertices[i * 3 + 0] = x;
 				vertices[i * 3 + 1] = y + 1;
@@ -538,7 +501,8 @@ GLuint createBoard(const bool startWithBlue)
 				colors[i * 4 + 2] = b;
 				colors[i * 4 + 3] = 1.0;
 
-				indices[i] = i++;
+				indices[i] = i;
+				i++;
 
 				vertices[i * 3 + 0] = x + 1;
 				vertices[i * 3 + 1] = y + 1;
@@ -549,25 +513,26 @@ GLuint createBoard(const bool startWithBlue)
 				colors[i * 4 + 2] = b;
 				colors[i * 4 + 3] = 1.0;
 
-				indices[i] = i++;
+				indices[i] = i;
+				i++;
 			}
 		}
 	}
 
-	// Generate vao
-	GLuint vaoID = generateExtrudedVertexArray(vertices, colors, indices, triangleCount, 1.0f);
+	// Generate mesh
+	const int meshID = generateExtrudedMesh(vertices, colors, indices, triangleCount, 1.0f);
 
 	// Cleaning up after ourselves
 	delete[] vertices;
 	delete[] indices;
 	delete[] colors;
 
-	// Return vao
-	return vaoID;
+	// Return mesh
+	return meshID;
 }
 
 // Creates the move marker (a yellow quad)
-GLuint createMoveMarker()
+int createMoveMarker()
 {
 	const unsigned int triangleCount = 2;
 
@@ -588,7 +553,8 @@ GLuint createMoveMarker()
 		colors[i * 4 + 2] = 0.25f;
 		colors[i * 4 + 3] = 1.0;
 
-		indices[i] = i++;
+		indices[i] = i;
+		i++;
 
 		vertices[i * 3 + 0] = 0;
 		vertices[i * 3 + 1] = 1;
@@ -599,7 +565,8 @@ GLuint createMoveMarker()
 		colors[i * 4 + 2] = 0.25f;
 		colors[i * 4 + 3] = 1.0;
 
-		indices[i] = i++;
+		indices[i] = i;
+		i++;
 
 		vertices[i * 3 + 0] = 1;
 		vertices[i * 3 + 1] = 0;
@@ -610,7 +577,8 @@ GLuint createMoveMarker()
 		colors[i * 4 + 2] = 0.25f;
 		colors[i * 4 + 3] = 1.0;
 
-		indices[i] = i++;
+		indices[i] = i;
+		i++;
 	}
 
 	// Triangle 2
@@ -624,7 +592,8 @@ GLuint createMoveMarker()
 		colors[i * 4 + 2] = 0.25f;
 		colors[i * 4 + 3] = 1.0;
 
-		indices[i] = i++;
+		indices[i] = i;
+		i++;
 
 		vertices[i * 3 + 0] = 0;
 		vertices[i * 3 + 1] = 1;
@@ -635,7 +604,8 @@ GLuint createMoveMarker()
 		colors[i * 4 + 2] = 0.25f;
 		colors[i * 4 + 3] = 1.0;
 
-		indices[i] = i++;
+		indices[i] = i;
+		i++;
 
 		vertices[i * 3 + 0] = 1;
 		vertices[i * 3 + 1] = 1;
@@ -646,17 +616,43 @@ GLuint createMoveMarker()
 		colors[i * 4 + 2] = 0.25f;
 		colors[i * 4 + 3] = 1.0;
 
-		indices[i] = i++;
+		indices[i] = i;
+		i++;
 	}
 
-	// Generate vao
-	GLuint vaoID = generateVertexArray(vertices, colors, indices, triangleCount);
+	// Generate mesh
+	const int meshID = generateMesh(vertices, colors, indices, triangleCount);
 
 	// Cleaning up after ourselves
 	delete[] vertices;
 	delete[] indices;
 	delete[] colors;
 
-	// Return vao
-	return vaoID;
-}
\ No newline at end of file
+	// Return mesh
+	return meshID;
+}
+// Returns the model for 'shape', creating it the first time. Every tile with the same shape shares the mesh,
+// so draws of the same shape can be batched by the draw list.
+int getShapeMesh(const Shape shape)
+{
+	static int shapeMeshIDs[SHAPE_COUNT] = {};
+	if(shapeMeshIDs[shape] == 0) shapeMeshIDs[shape] = createShape(shape) + 1;
+	return shapeMeshIDs[shape] - 1;
+}
+
+// Returns the board model for 'startWithBlue', creating it the first time. Every board with the same
+// colour pattern shares the mesh.
+int getBoardMesh(const bool startWithBlue)
+{
+	static int boardMeshIDs[2] = {};
+	if(boardMeshIDs[startWithBlue] == 0) boardMeshIDs[startWithBlue] = createBoard(startWithBlue) + 1;
+	return boardMeshIDs[startWithBlue] - 1;
+}
+
+// Returns the move marker model, creating it the first time
+int getMoveMarkerMesh()
+{
+	static int moveMarkerMeshID = 0;
+	if(moveMarkerMeshID == 0) moveMarkerMeshID = createMoveMarker() + 1;
+	return moveMarkerMeshID - 1;
+}
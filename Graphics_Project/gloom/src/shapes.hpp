@@ -2,21 +2,12 @@
 
 #include <math.h>
 #include "program.hpp"
+#include "boardState.hpp"
 #include "gloom/gloom.hpp"
 
-enum Shape
-{
-	SHAPE_NONE,
-	TRIANGLE,
-	PARALLELOGRAM,
-	ARROW,
-	HEXAGON_WHITE,
-	HEXAGON_BLACK,
-	STAR,
-	CAKE,
-	SHAPE_COUNT
-};
-
-GLuint createShape(const Shape shape);
-GLuint createBoard(const bool startWithBlue);
-GLuint createMoveMarker();
\ No newline at end of file
+int createShape(const Shape shape);
+int getShapeMesh(const Shape shape);
+int createBoard(const bool startWithBlue);
+int createMoveMarker();
+int getBoardMesh(const bool startWithBlue);
+int getMoveMarkerMesh();
\ No newline at end of file
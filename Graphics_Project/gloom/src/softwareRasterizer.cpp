@@ -0,0 +1,373 @@
+#include "softwareRasterizer.hpp"
+#include "mesh.hpp"
+#include "jobSystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include <stb_image_write.h>
+
+// Colour of selected shapes (see simple.frag)
+static const glm::vec3 selectedColor(0.75f, 0.75f, 0.25f);
+
+// Vertex in clip space (the output of simple.vert)
+struct ClipVertex
+{
+	glm::vec4 position;
+	glm::vec3 color;
+};
+
+// Edge of a triangle. The endpoints are stored in a canonical order, so the two triangles that share an edge evaluate
+// exactly the same edge function (one of them negated), which leaves no gaps or double hits along the edge.
+struct RasterEdge
+{
+	float x, y; // Canonical start point
+	float dx, dy; // Canonical direction
+	float sign; // -1 if the edge runs against the canonical direction
+	bool inclusive; // Pixels exactly on the edge belong to the triangle (top-left rule)
+};
+
+// Triangle in window space, ready to be rasterized
+struct RasterTriangle
+{
+	RasterEdge edges[3]; // Edge i is opposite of vertex i
+	float invArea; // 1 / (twice the area)
+	float z[3]; // Window space depth
+	float invW[3]; // 1 / clip w, for perspective correct interpolation
+	glm::vec3 color[3]; // Colour divided by clip w
+	int minX, minY, maxX, maxY; // Pixel bounds (inclusive)
+};
+
+// Packs a colour into RGBA8 (like a unorm framebuffer)
+static inline uint32_t packColor(const glm::vec4 &color)
+{
+	const glm::vec4 c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+	return (uint32_t) c.r | ((uint32_t) c.g << 8) | ((uint32_t) c.b << 16) | ((uint32_t) c.a << 24);
+}
+
+// Sets up the edge from 'a' to 'b'
+static RasterEdge setupEdge(const glm::vec2 &a, const glm::vec2 &b)
+{
+	// In GL window space (y up), the left edges of a counter-clockwise triangle run down and the top edges run left
+	RasterEdge edge;
+	edge.inclusive = b.y < a.y || (b.y == a.y && b.x < a.x);
+
+	const bool swap = a.y > b.y || (a.y == b.y && a.x > b.x);
+	const glm::vec2 &start = swap ? b : a;
+	const glm::vec2 &end = swap ? a : b;
+	edge.x = start.x;
+	edge.y = start.y;
+	edge.dx = end.x - start.x;
+	edge.dy = end.y - start.y;
+	edge.sign = swap ? -1.0f : 1.0f;
+	return edge;
+}
+
+// Evaluates the edge function at pixel center (px, py). It is positive on the inside of the triangle.
+// 'row' is edge.dx * (py - edge.y), which is shared by a row of pixels.
+static inline float evaluateEdge(const RasterEdge &edge, const float row, const float px)
+{
+	return edge.sign * (row - edge.dy * (px - edge.x));
+}
+
+// Projects a triangle in clip space to the window, and appends it to 'triangles' unless it's back facing or off screen
+static void setupTriangle(const ClipVertex *vertices, const int width, const int height, std::vector<RasterTriangle> &triangles)
+{
+	RasterTriangle triangle;
+	glm::vec2 p[3];
+	for(int i = 0; i < 3; i++)
+	{
+		const float invW = 1.0f / vertices[i].position.w;
+		const glm::vec3 ndc = glm::vec3(vertices[i].position) * invW;
+		p[i] = glm::vec2((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height);
+		triangle.z[i] = ndc.z * 0.5f + 0.5f;
+		triangle.invW[i] = invW;
+		triangle.color[i] = vertices[i].color * invW;
+	}
+
+	// Cull back facing and degenerate triangles
+	const float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+	if(!(area > 0.0f)) return;
+
+	// Pixels whose centers are inside the bounding box, clamped to the framebuffer
+	const float minX = std::max(std::min(std::min(p[0].x, p[1].x), p[2].x), -1.0f);
+	const float minY = std::max(std::min(std::min(p[0].y, p[1].y), p[2].y), -1.0f);
+	const float maxX = std::min(std::max(std::max(p[0].x, p[1].x), p[2].x), width + 1.0f);
+	const float maxY = std::min(std::max(std::max(p[0].y, p[1].y), p[2].y), height + 1.0f);
+	triangle.minX = std::max((int) ceilf(minX - 0.5f), 0);
+	triangle.minY = std::max((int) ceilf(minY - 0.5f), 0);
+	triangle.maxX = std::min((int) floorf(maxX - 0.5f), width - 1);
+	triangle.maxY = std::min((int) floorf(maxY - 0.5f), height - 1);
+	if(triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) return;
+
+	triangle.edges[0] = setupEdge(p[1], p[2]);
+	triangle.edges[1] = setupEdge(p[2], p[0]);
+	triangle.edges[2] = setupEdge(p[0], p[1]);
+	triangle.invArea = 1.0f / area;
+	triangles.push_back(triangle);
+}
+
+// Clips a triangle against the near plane (z >= -w) and sets up the resulting one or two triangles.
+// The other planes are handled by the bounding box and the depth test.
+static void clipTriangle(const ClipVertex *vertices, const int width, const int height, std::vector<RasterTriangle> &triangles)
+{
+	ClipVertex polygon[4];
+	int count = 0;
+	for(int i = 0; i < 3; i++)
+	{
+		const ClipVertex &a = vertices[i];
+		const ClipVertex &b = vertices[(i + 1) % 3];
+		const float distanceA = a.position.z + a.position.w;
+		const float distanceB = b.position.z + b.position.w;
+		if(distanceA >= 0.0f)
+		{
+			polygon[count++] = a;
+		}
+		if((distanceA >= 0.0f) != (distanceB >= 0.0f))
+		{
+			const float t = distanceA / (distanceA - distanceB);
+			polygon[count].position = glm::mix(a.position, b.position, t);
+			polygon[count].color = glm::mix(a.color, b.color, t);
+			count++;
+		}
+	}
+
+	for(int i = 1; i + 1 < count; i++)
+	{
+		const ClipVertex triangle[3] = { polygon[0], polygon[i], polygon[i + 1] };
+		setupTriangle(triangle, width, height, triangles);
+	}
+}
+
+// Runs simple.vert on the vertices of an instance and sets up its triangles
+static void setupInstance(const DrawInstance &instance, const int width, const int height, std::vector<ClipVertex> &vertices, std::vector<RasterTriangle> &triangles)
+{
+	const Mesh &mesh = getMesh(instance.meshID);
+	const unsigned int vertexCount = mesh.vertexData.size() / MESH_VERTEX_STRIDE;
+	vertices.resize(vertexCount);
+	for(unsigned int v = 0; v < vertexCount; v++)
+	{
+		// Selected shapes are drawn in the selection colour (simple.frag does this per fragment, but it doesn't vary)
+		const float *data = &mesh.vertexData[v * MESH_VERTEX_STRIDE];
+		vertices[v].position = instance.modelViewProjection * glm::vec4(data[0], data[1], data[2], 1.0f);
+		vertices[v].color = instance.selected ? selectedColor : glm::vec3(data[3], data[4], data[5]);
+	}
+
+	for(unsigned int i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		const ClipVertex triangle[3] = { vertices[mesh.indices[i]], vertices[mesh.indices[i + 1]], vertices[mesh.indices[i + 2]] };
+		clipTriangle(triangle, width, height, triangles);
+	}
+}
+
+#ifdef SOFTWARE_RASTERIZER_SSE
+
+// Rasterizes the part of a triangle inside the pixel rectangle [x0, x1] x [y0, y1], four pixels at a time.
+// 'x0' is a multiple of 4, and so is the width of the rectangle, unless it ends in the padding of the rows.
+static void rasterizeTriangle(SoftwareFramebuffer &framebuffer, const RasterTriangle &triangle, const int x0, const int y0, const int x1, const int y1)
+{
+	const int minX = std::max(triangle.minX, x0) & ~3;
+	const int maxX = std::min(triangle.maxX, x1);
+	const int minY = std::max(triangle.minY, y0);
+	const int maxY = std::min(triangle.maxY, y1);
+
+	const __m128 pixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 invArea = _mm_set1_ps(triangle.invArea);
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+
+	for(int y = minY; y <= maxY; y++)
+	{
+		const float py = y + 0.5f;
+		__m128 rows[3];
+		for(int e = 0; e < 3; e++)
+		{
+			rows[e] = _mm_set1_ps(triangle.edges[e].dx * (py - triangle.edges[e].y));
+		}
+
+		uint32_t *colorRow = &framebuffer.color[y * framebuffer.stride];
+		float *depthRow = &framebuffer.depth[y * framebuffer.stride];
+		for(int x = minX; x <= maxX; x += 4)
+		{
+			// Coverage
+			const __m128 px = _mm_add_ps(_mm_set1_ps((float) x), pixelOffsets);
+			__m128 w[3];
+			__m128 mask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for(int e = 0; e < 3; e++)
+			{
+				const RasterEdge &edge = triangle.edges[e];
+				w[e] = _mm_mul_ps(_mm_set1_ps(edge.sign), _mm_sub_ps(rows[e], _mm_mul_ps(_mm_set1_ps(edge.dy), _mm_sub_ps(px, _mm_set1_ps(edge.x)))));
+				mask = _mm_and_ps(mask, edge.inclusive ? _mm_cmpge_ps(w[e], zero) : _mm_cmpgt_ps(w[e], zero));
+			}
+			if(_mm_movemask_ps(mask) == 0) continue;
+
+			// Depth test (GL_LESS, and the far plane)
+			const __m128 l0 = _mm_mul_ps(w[0], invArea);
+			const __m128 l1 = _mm_mul_ps(w[1], invArea);
+			const __m128 l2 = _mm_mul_ps(w[2], invArea);
+			const __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(l0, _mm_set1_ps(triangle.z[0])), _mm_mul_ps(l1, _mm_set1_ps(triangle.z[1]))), _mm_mul_ps(l2, _mm_set1_ps(triangle.z[2])));
+			const __m128 oldDepth = _mm_loadu_ps(depthRow + x);
+			mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmplt_ps(z, oldDepth), _mm_cmple_ps(z, one)));
+			if(_mm_movemask_ps(mask) == 0) continue;
+			_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, oldDepth)));
+
+			// Perspective correct colour
+			const __m128 invW = _mm_add_ps(_mm_add_ps(_mm_mul_ps(l0, _mm_set1_ps(triangle.invW[0])), _mm_mul_ps(l1, _mm_set1_ps(triangle.invW[1]))), _mm_mul_ps(l2, _mm_set1_ps(triangle.invW[2])));
+			const __m128 scale = _mm_div_ps(_mm_set1_ps(255.0f), invW);
+			__m128i color = alpha;
+			for(int c = 0; c < 3; c++)
+			{
+				__m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(l0, _mm_set1_ps(triangle.color[0][c])), _mm_mul_ps(l1, _mm_set1_ps(triangle.color[1][c]))), _mm_mul_ps(l2, _mm_set1_ps(triangle.color[2][c])));
+				value = _mm_min_ps(_mm_max_ps(_mm_mul_ps(value, scale), zero), _mm_set1_ps(255.0f));
+				color = _mm_or_si128(color, _mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(value, _mm_set1_ps(0.5f))), c * 8));
+			}
+			const __m128i oldColor = _mm_loadu_si128((const __m128i*) (colorRow + x));
+			const __m128i colorMask = _mm_castps_si128(mask);
+			_mm_storeu_si128((__m128i*) (colorRow + x), _mm_or_si128(_mm_and_si128(colorMask, color), _mm_andnot_si128(colorMask, oldColor)));
+		}
+	}
+}
+
+#else
+
+// Rasterizes the part of a triangle inside the pixel rectangle [x0, x1] x [y0, y1]
+static void rasterizeTriangle(SoftwareFramebuffer &framebuffer, const RasterTriangle &triangle, const int x0, const int y0, const int x1, const int y1)
+{
+	const int minX = std::max(triangle.minX, x0);
+	const int maxX = std::min(triangle.maxX, x1);
+	const int minY = std::max(triangle.minY, y0);
+	const int maxY = std::min(triangle.maxY, y1);
+
+	for(int y = minY; y <= maxY; y++)
+	{
+		const float py = y + 0.5f;
+		float rows[3];
+		for(int e = 0; e < 3; e++)
+		{
+			rows[e] = triangle.edges[e].dx * (py - triangle.edges[e].y);
+		}
+
+		uint32_t *colorRow = &framebuffer.color[y * framebuffer.stride];
+		float *depthRow = &framebuffer.depth[y * framebuffer.stride];
+		for(int x = minX; x <= maxX; x++)
+		{
+			// Coverage
+			const float px = x + 0.5f;
+			float w[3];
+			bool inside = true;
+			for(int e = 0; e < 3; e++)
+			{
+				const RasterEdge &edge = triangle.edges[e];
+				w[e] = evaluateEdge(edge, rows[e], px);
+				inside = inside && (edge.inclusive ? w[e] >= 0.0f : w[e] > 0.0f);
+			}
+			if(!inside) continue;
+
+			// Depth test (GL_LESS, and the far plane)
+			const float l0 = w[0] * triangle.invArea, l1 = w[1] * triangle.invArea, l2 = w[2] * triangle.invArea;
+			const float z = l0 * triangle.z[0] + l1 * triangle.z[1] + l2 * triangle.z[2];
+			if(!(z < depthRow[x] && z <= 1.0f)) continue;
+			depthRow[x] = z;
+
+			// Perspective correct colour
+			const float invW = l0 * triangle.invW[0] + l1 * triangle.invW[1] + l2 * triangle.invW[2];
+			const glm::vec3 color = (l0 * triangle.color[0] + l1 * triangle.color[1] + l2 * triangle.color[2]) / invW;
+			colorRow[x] = packColor(glm::vec4(color, 1.0f));
+		}
+	}
+}
+
+#endif
+
+SoftwareFramebuffer createSoftwareFramebuffer(const int width, const int height)
+{
+	SoftwareFramebuffer framebuffer;
+	framebuffer.width = width;
+	framebuffer.height = height;
+	framebuffer.stride = (width + 3) & ~3;
+	framebuffer.color.resize(framebuffer.stride * height);
+	framebuffer.depth.resize(framebuffer.stride * height);
+	return framebuffer;
+}
+
+void clearSoftwareFramebuffer(SoftwareFramebuffer &framebuffer, const glm::vec4 &color, const float depth)
+{
+	std::fill(framebuffer.color.begin(), framebuffer.color.end(), packColor(color));
+	std::fill(framebuffer.depth.begin(), framebuffer.depth.end(), depth);
+}
+
+void drawSoftwareInstances(SoftwareFramebuffer &framebuffer, const DrawInstance *instances, const unsigned int count)
+{
+	// Set up the triangles of every instance in parallel
+	std::vector<std::vector<RasterTriangle> > instanceTriangles(count);
+	parallelFor(count, 1, [&](const unsigned int begin, const unsigned int end)
+	{
+		std::vector<ClipVertex> vertices;
+		for(unsigned int i = begin; i < end; i++)
+		{
+			setupInstance(instances[i], framebuffer.width, framebuffer.height, vertices, instanceTriangles[i]);
+		}
+	});
+
+	// Bin the triangles into the tiles they overlap, in draw order
+	const int tileColumns = (framebuffer.width + RASTERIZER_TILE_SIZE - 1) / RASTERIZER_TILE_SIZE;
+	const int tileRows = (framebuffer.height + RASTERIZER_TILE_SIZE - 1) / RASTERIZER_TILE_SIZE;
+	std::vector<std::vector<const RasterTriangle*> > bins(tileColumns * tileRows);
+	for(const std::vector<RasterTriangle> &triangles : instanceTriangles)
+	{
+		for(const RasterTriangle &triangle : triangles)
+		{
+			for(int tileY = triangle.minY / RASTERIZER_TILE_SIZE; tileY <= triangle.maxY / RASTERIZER_TILE_SIZE; tileY++)
+			{
+				for(int tileX = triangle.minX / RASTERIZER_TILE_SIZE; tileX <= triangle.maxX / RASTERIZER_TILE_SIZE; tileX++)
+				{
+					bins[tileY * tileColumns + tileX].push_back(&triangle);
+				}
+			}
+		}
+	}
+
+	// Rasterize the tiles in parallel, every pixel belongs to one tile so the jobs don't need to synchronize
+	parallelFor(bins.size(), 1, [&](const unsigned int begin, const unsigned int end)
+	{
+		for(unsigned int tile = begin; tile < end; tile++)
+		{
+			const int x0 = (tile % tileColumns) * RASTERIZER_TILE_SIZE;
+			const int y0 = (tile / tileColumns) * RASTERIZER_TILE_SIZE;
+			const int x1 = std::min(x0 + RASTERIZER_TILE_SIZE, framebuffer.width) - 1;
+			const int y1 = std::min(y0 + RASTERIZER_TILE_SIZE, framebuffer.height) - 1;
+			for(const RasterTriangle *triangle : bins[tile])
+			{
+				rasterizeTriangle(framebuffer, *triangle, x0, y0, x1, y1);
+			}
+		}
+	});
+}
+
+bool saveSoftwareFramebuffer(const SoftwareFramebuffer &framebuffer, const std::string &filepath)
+{
+	// Flip the rows, images are stored top to bottom
+	std::vector<uint32_t> pixels(framebuffer.width * framebuffer.height);
+	for(int y = 0; y < framebuffer.height; y++)
+	{
+		const uint32_t *row = &framebuffer.color[(framebuffer.height - 1 - y) * framebuffer.stride];
+		std::copy(row, row + framebuffer.width, pixels.begin() + y * framebuffer.width);
+	}
+	return stbi_write_png(filepath.c_str(), framebuffer.width, framebuffer.height, 4, pixels.data(), framebuffer.width * 4) != 0;
+}
+
+bool saveSoftwareDepth(const SoftwareFramebuffer &framebuffer, const std::string &filepath)
+{
+	FILE *file = fopen(filepath.c_str(), "wb");
+	if(!file) return false;
+
+	// A negative scale marks little-endian floats, the rows are already stored bottom to top
+	bool written = fprintf(file, "Pf\n%d %d\n-1.0\n", framebuffer.width, framebuffer.height) > 0;
+	for(int y = 0; y < framebuffer.height && written; y++)
+	{
+		written = fwrite(&framebuffer.depth[y * framebuffer.stride], sizeof(float), framebuffer.width, file) == (size_t) framebuffer.width;
+	}
+	return fclose(file) == 0 && written;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "drawInstance.hpp"
+#include "simdMath.hpp"
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// CPU rasterizer that draws the same instances and registered meshes as the GL path, for machines without a GPU
+// and as a reference renderer. Triangles are set up in parallel per instance, binned into screen tiles, and the
+// tiles are rasterized in parallel on the job system (see jobSystem.hpp), so initJobSystem() must have been called.
+// The output doesn't depend on the number of threads.
+// Only the geometry matches the GL path: the coverage and the depth buffer are the same, but the colour is the
+// vertex colour alone. simple.frag also multiplies it by the material texture and darkens it in the cascaded
+// shadows, which are not done here. Compare against GL with the depth buffer (saveSoftwareDepth()), not the colour.
+
+// Use the SSE kernel when the target supports SSE2 (define SOFTWARE_RASTERIZER_SCALAR to force the scalar path)
+#if !defined(SOFTWARE_RASTERIZER_SCALAR) && defined(SIMD_MATH_SSE)
+	#define SOFTWARE_RASTERIZER_SSE 1
+#endif
+
+// Width and height of a screen tile (pixels, a multiple of 4)
+#define RASTERIZER_TILE_SIZE 64
+
+// Colour and depth buffer in CPU memory. Rows are stored bottom to top like in a GL framebuffer,
+// and padded to a multiple of 4 pixels.
+struct SoftwareFramebuffer
+{
+	int width, height;
+	int stride; // Pixels per row
+	std::vector<uint32_t> color; // RGBA8 (red in the lowest byte)
+	std::vector<float> depth; // Window space depth in [0, 1]
+};
+
+// Creates a framebuffer of 'width' x 'height' pixels
+SoftwareFramebuffer createSoftwareFramebuffer(const int width, const int height);
+
+// Clears the colour and depth buffers (like glClear)
+void clearSoftwareFramebuffer(SoftwareFramebuffer &framebuffer, const glm::vec4 &color, const float depth = 1.0f);
+
+// Draws 'count' instances like simple.vert and simple.frag do (without the material textures and the shadows), with
+// back face culling (counter-clockwise front faces) and a GL_LESS depth test
+void drawSoftwareInstances(SoftwareFramebuffer &framebuffer, const DrawInstance *instances, const unsigned int count);
+
+// Writes the colour buffer to a PNG file (top row first). Returns false if the file couldn't be written.
+bool saveSoftwareFramebuffer(const SoftwareFramebuffer &framebuffer, const std::string &filepath);
+
+// Writes the depth buffer to a PFM file (one little-endian float per pixel, bottom row first like glReadPixels with
+// GL_DEPTH_COMPONENT), so it can be compared with the GL depth buffer exactly. Returns false if the file couldn't
+// be written.
+bool saveSoftwareDepth(const SoftwareFramebuffer &framebuffer, const std::string &filepath);
@@ -0,0 +1,280 @@
+#include "textureLoader.hpp"
+#include "jobSystem.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// The stb image libraries are compiled here
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+#ifdef _WIN32
+	#include <direct.h>
+#else
+	#include <sys/stat.h>
+#endif
+
+// Texture cache file header (followed by the compressed mips)
+struct TextureCacheHeader
+{
+	char magic[4]; // "GTEX"
+	uint32_t version;
+	uint32_t layerSize; // TEXTURE_LAYER_SIZE when the file was written
+	uint32_t mipCount;
+	uint32_t format; // TextureFormat
+	uint32_t dataBytes; // Bytes of the mips (after decompressing the file)
+	uint64_t sourceHash; // Hash of the image file
+	uint32_t compressedBytes; // Bytes of the zlib compressed mips in the file
+	uint32_t padding;
+};
+
+#define TEXTURE_CACHE_VERSION 2
+
+// Blocks per compression job
+#define TEXTURE_COMPRESSION_JOB_SIZE 64
+
+const char *getTextureFormatName(const TextureFormat format)
+{
+	static const char *names[TEXTURE_FORMAT_COUNT] = { "RGBA8", "BC1", "BC3" };
+	return format < TEXTURE_FORMAT_COUNT ? names[format] : "INVALID";
+}
+
+// Returns the number of 4 x 4 blocks along the side of mip level 'mip' (partial blocks count as whole)
+static int getTextureMipBlocks(const int mip)
+{
+	return (getTextureMipSize(mip) + 3) / 4;
+}
+
+size_t getTextureMipBytes(const TextureFormat format, const int mip)
+{
+	const size_t blocks = (size_t) getTextureMipBlocks(mip) * getTextureMipBlocks(mip);
+	switch(format)
+	{
+		case TEXTURE_FORMAT_BC1: return blocks * 8;
+		case TEXTURE_FORMAT_BC3: return blocks * 16;
+		default: return (size_t) getTextureMipSize(mip) * getTextureMipSize(mip) * 4;
+	}
+}
+
+size_t getTextureMipOffset(const TextureFormat format, const int mip)
+{
+	size_t offset = 0;
+	for(int level = 0; level < mip; level++)
+	{
+		offset += getTextureMipBytes(format, level);
+	}
+	return offset;
+}
+
+// Bytes of a layer with every mip
+static size_t getTextureLayerBytes(const TextureFormat format)
+{
+	return getTextureMipOffset(format, TEXTURE_MIP_COUNT);
+}
+
+void createSolidTextureLayer(const glm::vec4 &color, const TextureFormat format, TextureLayer &layer)
+{
+	const glm::vec4 bytes = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+	const uint8_t pixel[4] = { (uint8_t) bytes.r, (uint8_t) bytes.g, (uint8_t) bytes.b, (uint8_t) bytes.a };
+	layer.format = TEXTURE_FORMAT_RGBA8;
+	layer.data.resize(getTextureLayerBytes(TEXTURE_FORMAT_RGBA8));
+	for(size_t i = 0; i < layer.data.size(); i += 4)
+	{
+		memcpy(&layer.data[i], pixel, 4);
+	}
+	compressTextureLayer(layer, format);
+}
+
+void compressTextureLayer(TextureLayer &layer, const TextureFormat format)
+{
+	if(layer.format == format || layer.format != TEXTURE_FORMAT_RGBA8) return;
+
+	// The bundled stb_dxt (v1.04) fills its quantization tables in the first call of stb_compress_dxt_block(), guarded
+	// by an unsynchronized static flag, so make that call on this thread before the jobs compress blocks in parallel
+	const int alpha = format == TEXTURE_FORMAT_BC3 ? 1 : 0;
+	const size_t blockBytes = alpha ? 16 : 8;
+	{
+		uint8_t block[16 * 4] = {}, output[16];
+		stb_compress_dxt_block(output, block, alpha, STB_DXT_HIGHQUAL);
+	}
+
+	std::vector<uint8_t> data(getTextureLayerBytes(format));
+	for(int mip = 0; mip < TEXTURE_MIP_COUNT; mip++)
+	{
+		// Compress the blocks of the mip in parallel. Blocks that reach past the edge of the small mips (2 x 2 and
+		// 1 x 1) repeat the edge pixels.
+		const uint8_t *pixels = &layer.data[getTextureMipOffset(TEXTURE_FORMAT_RGBA8, mip)];
+		uint8_t *blocks = &data[getTextureMipOffset(format, mip)];
+		const int size = getTextureMipSize(mip);
+		const int blocksPerRow = getTextureMipBlocks(mip);
+		parallelFor(blocksPerRow * blocksPerRow, TEXTURE_COMPRESSION_JOB_SIZE, [=](unsigned int begin, unsigned int end)
+		{
+			uint8_t block[16 * 4];
+			for(unsigned int i = begin; i < end; i++)
+			{
+				const int blockX = (i % blocksPerRow) * 4, blockY = (i / blocksPerRow) * 4;
+				for(int y = 0; y < 4; y++)
+				{
+					for(int x = 0; x < 4; x++)
+					{
+						const int pixelX = std::min(blockX + x, size - 1), pixelY = std::min(blockY + y, size - 1);
+						memcpy(&block[(y * 4 + x) * 4], &pixels[(pixelY * size + pixelX) * 4], 4);
+					}
+				}
+				stb_compress_dxt_block(&blocks[i * blockBytes], block, alpha, STB_DXT_HIGHQUAL);
+			}
+		});
+	}
+	layer.format = format;
+	layer.data.swap(data);
+}
+
+// Reads the whole file into 'data'
+static bool readFile(const std::string &filepath, std::vector<uint8_t> &data)
+{
+	FILE *file = fopen(filepath.c_str(), "rb");
+	if(!file) return false;
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	data.resize(size > 0 ? size : 0);
+	const bool success = size >= 0 && fread(data.data(), 1, data.size(), file) == data.size();
+	fclose(file);
+	return success;
+}
+
+// 64-bit FNV-1a hash of 'data'
+static uint64_t hashBytes(const uint8_t *data, const size_t size)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for(size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ data[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+// Returns the path of the cache file of an image with hash 'sourceHash' in 'format'
+static std::string getCachePath(const std::string &cacheDirectory, const uint64_t sourceHash, const TextureFormat format)
+{
+	char name[48];
+	snprintf(name, sizeof(name), "%016llx_%s.tex", (unsigned long long) sourceHash, getTextureFormatName(format));
+	return cacheDirectory + "/" + name;
+}
+
+// Reads the cached layer of the image with hash 'sourceHash' in 'format'. Returns false if there is no valid cache file.
+static bool readTextureCache(const std::string &cacheDirectory, const uint64_t sourceHash, const TextureFormat format, TextureLayer &layer)
+{
+	std::vector<uint8_t> data;
+	if(!readFile(getCachePath(cacheDirectory, sourceHash, format), data) || data.size() < sizeof(TextureCacheHeader)) return false;
+
+	TextureCacheHeader header;
+	memcpy(&header, data.data(), sizeof(header));
+	if(memcmp(header.magic, "GTEX", 4) != 0 || header.version != TEXTURE_CACHE_VERSION || header.layerSize != TEXTURE_LAYER_SIZE
+		|| header.mipCount != TEXTURE_MIP_COUNT || header.format != (uint32_t) format || header.sourceHash != sourceHash
+		|| header.dataBytes != getTextureLayerBytes(format) || header.compressedBytes != data.size() - sizeof(header))
+	{
+		return false;
+	}
+
+	layer.format = format;
+	layer.data.resize(header.dataBytes);
+	return stbi_zlib_decode_buffer((char*) layer.data.data(), header.dataBytes, (const char*) data.data() + sizeof(header), header.compressedBytes)
+		== (int) header.dataBytes;
+}
+
+// Writes 'layer' to the cache. Failing to write the cache isn't an error, the image is just loaded again next time.
+static void writeTextureCache(const std::string &cacheDirectory, const uint64_t sourceHash, const TextureLayer &layer)
+{
+#ifdef _WIN32
+	_mkdir(cacheDirectory.c_str());
+#else
+	mkdir(cacheDirectory.c_str(), 0755);
+#endif
+
+	// stb_image_write's zlib compressor returns a buffer that must be released with free()
+	int compressedBytes = 0;
+	unsigned char *compressed = stbi_zlib_compress((unsigned char*) layer.data.data(), layer.data.size(), &compressedBytes, 8);
+	if(!compressed) return;
+
+	TextureCacheHeader header;
+	memcpy(header.magic, "GTEX", 4);
+	header.version = TEXTURE_CACHE_VERSION;
+	header.layerSize = TEXTURE_LAYER_SIZE;
+	header.mipCount = TEXTURE_MIP_COUNT;
+	header.format = layer.format;
+	header.dataBytes = layer.data.size();
+	header.sourceHash = sourceHash;
+	header.compressedBytes = compressedBytes;
+	header.padding = 0;
+
+	// Write to a temporary file first, so a cache file is never half written
+	const std::string cachePath = getCachePath(cacheDirectory, sourceHash, layer.format);
+	const std::string temporaryPath = cachePath + ".tmp";
+	FILE *file = fopen(temporaryPath.c_str(), "wb");
+	if(file)
+	{
+		const bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(compressed, 1, compressedBytes, file) == (size_t) compressedBytes;
+		fclose(file);
+		remove(cachePath.c_str());
+		if(!written || rename(temporaryPath.c_str(), cachePath.c_str()) != 0) remove(temporaryPath.c_str());
+	}
+	free(compressed);
+}
+
+// Decodes the image in 'data' into an RGBA8 'layer' and generates its mips
+static bool decodeTextureLayer(const std::vector<uint8_t> &data, TextureLayer &layer, std::string *error)
+{
+	int width, height, channels;
+	stbi_uc *image = stbi_load_from_memory(data.data(), data.size(), &width, &height, &channels, 4);
+	if(!image)
+	{
+		if(error) *error = stbi_failure_reason();
+		return false;
+	}
+
+	// Resize to the layer size, then filter every mip from the one above it (in linear space, the alpha is channel 3)
+	layer.format = TEXTURE_FORMAT_RGBA8;
+	layer.data.resize(getTextureLayerBytes(TEXTURE_FORMAT_RGBA8));
+	stbir_resize_uint8_srgb(image, width, height, 0, layer.data.data(), TEXTURE_LAYER_SIZE, TEXTURE_LAYER_SIZE, 0, 4, 3, 0);
+	stbi_image_free(image);
+	for(int mip = 1; mip < TEXTURE_MIP_COUNT; mip++)
+	{
+		stbir_resize_uint8_srgb(&layer.data[getTextureMipOffset(TEXTURE_FORMAT_RGBA8, mip - 1)], getTextureMipSize(mip - 1), getTextureMipSize(mip - 1), 0,
+			&layer.data[getTextureMipOffset(TEXTURE_FORMAT_RGBA8, mip)], getTextureMipSize(mip), getTextureMipSize(mip), 0, 4, 3, 0);
+	}
+	return true;
+}
+
+bool loadTextureLayer(const std::string &filepath, const std::string &cacheDirectory, const TextureFormat format,
+	TextureLayer &layer, bool *fromCache, std::string *error)
+{
+	if(fromCache) *fromCache = false;
+	std::vector<uint8_t> data;
+	if(!readFile(filepath, data))
+	{
+		if(error) *error = "could not open file";
+		return false;
+	}
+
+	// Hashing the file is much cheaper than decoding it
+	const uint64_t sourceHash = hashBytes(data.data(), data.size());
+	if(!cacheDirectory.empty() && readTextureCache(cacheDirectory, sourceHash, format, layer))
+	{
+		if(fromCache) *fromCache = true;
+		return true;
+	}
+
+	if(!decodeTextureLayer(data, layer, error)) return false;
+	compressTextureLayer(layer, format);
+	if(!cacheDirectory.empty()) writeTextureCache(cacheDirectory, sourceHash, layer);
+	return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Loads textures for the layers of a texture array: every texture is resized to TEXTURE_LAYER_SIZE x TEXTURE_LAYER_SIZE,
+// gets a full mip chain, filtered with stb_image_resize, and is compressed to BC1 or BC3 with stb_dxt (the blocks are
+// compressed in parallel on the job system). Finished textures are cached on disk (zlib compressed, keyed by a hash of
+// the image file and the format), so later loads skip decoding, filtering and compression.
+
+// Width and height of a texture layer (a power of two)
+#define TEXTURE_LAYER_SIZE 256
+
+// Mip levels of a layer (TEXTURE_LAYER_SIZE down to 1 x 1)
+#define TEXTURE_MIP_COUNT 9
+
+// Formats of texture layers
+enum TextureFormat
+{
+	TEXTURE_FORMAT_RGBA8, // 4 bytes per pixel
+	TEXTURE_FORMAT_BC1, // DXT1, opaque: 8 bytes per 4 x 4 block (8:1)
+	TEXTURE_FORMAT_BC3, // DXT5, with alpha: 16 bytes per 4 x 4 block (4:1)
+	TEXTURE_FORMAT_COUNT
+};
+
+// A texture layer with its mips, largest first
+struct TextureLayer
+{
+	TextureFormat format;
+	std::vector<uint8_t> data; // Every mip tightly packed (compressed mips are padded to whole blocks)
+};
+
+// Returns the name of a format ("RGBA8", "BC1" or "BC3")
+const char *getTextureFormatName(const TextureFormat format);
+
+// Returns the size of mip level 'mip' in bytes
+size_t getTextureMipBytes(const TextureFormat format, const int mip);
+
+// Returns the offset of mip level 'mip' in TextureLayer::data (in bytes)
+size_t getTextureMipOffset(const TextureFormat format, const int mip);
+
+// Returns the width and height of mip level 'mip'
+inline int getTextureMipSize(const int mip)
+{
+	return TEXTURE_LAYER_SIZE >> mip;
+}
+
+// Fills 'layer' with one colour (RGBA in [0, 1])
+void createSolidTextureLayer(const glm::vec4 &color, const TextureFormat format, TextureLayer &layer);
+
+// Compresses an RGBA8 layer to 'format' (does nothing if the layer already has that format). The blocks are
+// compressed in parallel, but the function itself must not run on several threads at once before its first call
+// has returned (stb_dxt sets up its tables in that call).
+void compressTextureLayer(TextureLayer &layer, const TextureFormat format);
+
+// Loads the image 'filepath' into 'layer' in 'format'. If 'cacheDirectory' isn't empty, the layer is read from the
+// cache there (or written to it after loading). Returns false and sets 'error' if the image can't be loaded.
+// 'fromCache' is set if the layer came from the cache.
+bool loadTextureLayer(const std::string &filepath, const std::string &cacheDirectory, const TextureFormat format,
+	TextureLayer &layer, bool *fromCache = 0, std::string *error = 0);
@@ -0,0 +1,119 @@
+#include "transformKernel.hpp"
+
+#include <cmath>
+
+void resizeTransformBatch(TransformBatch &batch, const unsigned int size)
+{
+	batch.rotationX.resize(size);
+	batch.rotationY.resize(size);
+	batch.rotationZ.resize(size);
+	batch.x.resize(size);
+	batch.y.resize(size);
+	batch.z.resize(size);
+	batch.scale.resize(size);
+}
+
+// Writes Rx * Ry * Rz * T * S into 'matrix' given the sines and cosines of the three angles
+static inline void composeTransformMatrix(const float sx, const float cx, const float sy, const float cy, const float sz, const float cz,
+                                          const float tx, const float ty, const float tz, const float s, glm::mat4 &matrix)
+{
+	// Rotation matrix R = Rx * Ry * Rz (r[row][column])
+	const float r00 = cy * cz,                r01 = -cy * sz,                r02 = sy;
+	const float r10 = sx * sy * cz + cx * sz, r11 = -sx * sy * sz + cx * cz, r12 = -sx * cy;
+	const float r20 = -cx * sy * cz + sx * sz, r21 = cx * sy * sz + sx * cz, r22 = cx * cy;
+
+	// The upper 3x3 block is R * s and the translation is R * t
+	matrix[0] = glm::vec4(r00 * s, r10 * s, r20 * s, 0.0f);
+	matrix[1] = glm::vec4(r01 * s, r11 * s, r21 * s, 0.0f);
+	matrix[2] = glm::vec4(r02 * s, r12 * s, r22 * s, 0.0f);
+	matrix[3] = glm::vec4(r00 * tx + r01 * ty + r02 * tz,
+	                      r10 * tx + r11 * ty + r12 * tz,
+	                      r20 * tx + r21 * ty + r22 * tz, 1.0f);
+}
+
+void buildTransformMatricesScalar(const TransformBatch &batch, const unsigned int first, const unsigned int count, glm::mat4 *matrices)
+{
+	for(unsigned int i = first; i < first + count; i++)
+	{
+		composeTransformMatrix(sinf(batch.rotationX[i]), cosf(batch.rotationX[i]),
+		                       sinf(batch.rotationY[i]), cosf(batch.rotationY[i]),
+		                       sinf(batch.rotationZ[i]), cosf(batch.rotationZ[i]),
+		                       batch.x[i], batch.y[i], batch.z[i], batch.scale[i], matrices[i - first]);
+	}
+}
+
+#ifdef TRANSFORM_KERNEL_SSE
+
+void buildTransformMatrices(const TransformBatch &batch, const unsigned int first, const unsigned int count, glm::mat4 *matrices)
+{
+	const float *rotationX = batch.rotationX.data() + first;
+	const float *rotationY = batch.rotationY.data() + first;
+	const float *rotationZ = batch.rotationZ.data() + first;
+	const float *px = batch.x.data() + first;
+	const float *py = batch.y.data() + first;
+	const float *pz = batch.z.data() + first;
+	const float *scale = batch.scale.data() + first;
+
+	// Four nodes per iteration, one node per SIMD lane
+	unsigned int i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128 sx, cx, sy, cy, sz, cz;
+		sincos4(_mm_loadu_ps(rotationX + i), sx, cx);
+		sincos4(_mm_loadu_ps(rotationY + i), sy, cy);
+		sincos4(_mm_loadu_ps(rotationZ + i), sz, cz);
+		const __m128 tx = _mm_loadu_ps(px + i);
+		const __m128 ty = _mm_loadu_ps(py + i);
+		const __m128 tz = _mm_loadu_ps(pz + i);
+		const __m128 s = _mm_loadu_ps(scale + i);
+
+		// Rotation matrix R = Rx * Ry * Rz
+		const __m128 sxsy = _mm_mul_ps(sx, sy);
+		const __m128 cxsy = _mm_mul_ps(cx, sy);
+		const __m128 r00 = _mm_mul_ps(cy, cz);
+		const __m128 r01 = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(cy, sz));
+		const __m128 r02 = sy;
+		const __m128 r10 = _mm_add_ps(_mm_mul_ps(sxsy, cz), _mm_mul_ps(cx, sz));
+		const __m128 r11 = _mm_sub_ps(_mm_mul_ps(cx, cz), _mm_mul_ps(sxsy, sz));
+		const __m128 r12 = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(sx, cy));
+		const __m128 r20 = _mm_sub_ps(_mm_mul_ps(sx, sz), _mm_mul_ps(cxsy, cz));
+		const __m128 r21 = _mm_add_ps(_mm_mul_ps(cxsy, sz), _mm_mul_ps(sx, cz));
+		const __m128 r22 = _mm_mul_ps(cx, cy);
+
+		// Columns of the four matrices, one component per register
+		__m128 c0x = _mm_mul_ps(r00, s), c0y = _mm_mul_ps(r10, s), c0z = _mm_mul_ps(r20, s), c0w = _mm_setzero_ps();
+		__m128 c1x = _mm_mul_ps(r01, s), c1y = _mm_mul_ps(r11, s), c1z = _mm_mul_ps(r21, s), c1w = _mm_setzero_ps();
+		__m128 c2x = _mm_mul_ps(r02, s), c2y = _mm_mul_ps(r12, s), c2z = _mm_mul_ps(r22, s), c2w = _mm_setzero_ps();
+		__m128 c3x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r00, tx), _mm_mul_ps(r01, ty)), _mm_mul_ps(r02, tz));
+		__m128 c3y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r10, tx), _mm_mul_ps(r11, ty)), _mm_mul_ps(r12, tz));
+		__m128 c3z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r20, tx), _mm_mul_ps(r21, ty)), _mm_mul_ps(r22, tz));
+		__m128 c3w = _mm_set1_ps(1.0f);
+
+		// Transpose from one component per register to one column per register
+		_MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+		_MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+		_MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+		_MM_TRANSPOSE4_PS(c3x, c3y, c3z, c3w);
+
+		float *out = &matrices[i][0][0];
+		_mm_storeu_ps(out + 0, c0x);  _mm_storeu_ps(out + 4, c1x);  _mm_storeu_ps(out + 8, c2x);  _mm_storeu_ps(out + 12, c3x);
+		_mm_storeu_ps(out + 16, c0y); _mm_storeu_ps(out + 20, c1y); _mm_storeu_ps(out + 24, c2y); _mm_storeu_ps(out + 28, c3y);
+		_mm_storeu_ps(out + 32, c0z); _mm_storeu_ps(out + 36, c1z); _mm_storeu_ps(out + 40, c2z); _mm_storeu_ps(out + 44, c3z);
+		_mm_storeu_ps(out + 48, c0w); _mm_storeu_ps(out + 52, c1w); _mm_storeu_ps(out + 56, c2w); _mm_storeu_ps(out + 60, c3w);
+	}
+
+	// Remaining nodes
+	if(i < count)
+	{
+		buildTransformMatricesScalar(batch, first + i, count - i, matrices + i);
+	}
+}
+
+#else
+
+void buildTransformMatrices(const TransformBatch &batch, const unsigned int first, const unsigned int count, glm::mat4 *matrices)
+{
+	buildTransformMatricesScalar(batch, first, count, matrices);
+}
+
+#endif
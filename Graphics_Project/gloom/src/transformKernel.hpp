@@ -0,0 +1,29 @@
+#pragma once
+
+#include "simdMath.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+// Use the SSE kernel when the target supports SSE2 (define TRANSFORM_KERNEL_SCALAR to force the scalar path)
+#if !defined(TRANSFORM_KERNEL_SCALAR) && defined(SIMD_MATH_SSE)
+	#define TRANSFORM_KERNEL_SSE 1
+#endif
+
+// Rotation, translation and uniform scale of many nodes, stored as a structure of arrays
+struct TransformBatch
+{
+	std::vector<float> rotationX, rotationY, rotationZ; // Euler angles (radians)
+	std::vector<float> x, y, z; // Translation
+	std::vector<float> scale; // Uniform scale
+};
+
+// Resizes every array in the batch
+void resizeTransformBatch(TransformBatch &batch, const unsigned int size);
+
+// Builds the matrix Rx * Ry * Rz * T * S for the nodes [first, first + count) of the batch.
+// This is the same matrix as initTransformationMatrix() composes with glm::rotate/translate/scale.
+void buildTransformMatrices(const TransformBatch &batch, const unsigned int first, const unsigned int count, glm::mat4 *matrices);
+
+// Scalar version of buildTransformMatrices(), used as the fallback and as the reference for the SSE kernel
+void buildTransformMatricesScalar(const TransformBatch &batch, const unsigned int first, const unsigned int count, glm::mat4 *matrices);
@@ -0,0 +1,105 @@
+#include "uploadRing.hpp"
+
+#include <cstdio>
+
+// Creates and maps the buffer of 'ring' with 'regionSize' bytes per region
+static void createRingBuffer(UploadRing &ring, const GLsizeiptr regionSize)
+{
+	ring.regionSize = (regionSize + ring.alignment - 1) / ring.alignment * ring.alignment;
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &ring.buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ring.buffer);
+	glBufferStorage(GL_SHADER_STORAGE_BUFFER, ring.regionSize * UPLOAD_RING_REGION_COUNT, 0, flags);
+	ring.data = (char*) glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, ring.regionSize * UPLOAD_RING_REGION_COUNT, flags);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	if(!ring.data)
+	{
+		fprintf(stderr, "Could not map the upload ring\n");
+	}
+}
+
+// Waits until the GPU is done with 'region'
+static void waitForRegion(UploadRing &ring, const unsigned int region)
+{
+	GLsync &fence = ring.fences[region];
+	if(!fence) return;
+
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+	{
+		// The GPU is UPLOAD_RING_REGION_COUNT frames behind, wait for it (flushing the fence the first time)
+		ring.waits++;
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		do
+		{
+			status = glClientWaitSync(fence, flags, 1000000000);
+			flags = 0;
+		}
+		while(status == GL_TIMEOUT_EXPIRED);
+	}
+	glDeleteSync(fence);
+	fence = 0;
+}
+
+UploadRing createUploadRing(const GLsizeiptr regionSize)
+{
+	UploadRing ring;
+	GLint alignment;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	ring.alignment = alignment > 0 ? alignment : 1;
+	ring.region = UPLOAD_RING_REGION_COUNT - 1; // The first beginUploadRegion() moves to region 0
+	ring.offset = 0;
+	ring.bytesUploaded = 0;
+	ring.waits = 0;
+	for(int i = 0; i < UPLOAD_RING_REGION_COUNT; i++)
+	{
+		ring.fences[i] = 0;
+	}
+	createRingBuffer(ring, regionSize);
+	return ring;
+}
+
+void destroyUploadRing(UploadRing &ring)
+{
+	for(unsigned int i = 0; i < UPLOAD_RING_REGION_COUNT; i++)
+	{
+		waitForRegion(ring, i);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ring.buffer);
+	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glDeleteBuffers(1, &ring.buffer);
+	ring.buffer = 0;
+	ring.data = 0;
+}
+
+void beginUploadRegion(UploadRing &ring)
+{
+	ring.region = (ring.region + 1) % UPLOAD_RING_REGION_COUNT;
+	ring.offset = 0;
+	waitForRegion(ring, ring.region);
+}
+
+void *reserveUpload(UploadRing &ring, const GLsizeiptr size, GLintptr &offset)
+{
+	GLsizeiptr alignedOffset = (ring.offset + ring.alignment - 1) / ring.alignment * ring.alignment;
+	if(alignedOffset + size > ring.regionSize)
+	{
+		// Grow the ring. The other regions may still be in use, so wait for the GPU to finish with them first.
+		// Draws that were already submitted keep the old buffer alive until they're done.
+		const GLsizeiptr regionSize = 2 * (size > ring.regionSize ? size : ring.regionSize);
+		destroyUploadRing(ring);
+		createRingBuffer(ring, regionSize);
+		alignedOffset = 0;
+	}
+
+	ring.offset = alignedOffset + size;
+	ring.bytesUploaded += size;
+	offset = ring.region * ring.regionSize + alignedOffset;
+	return ring.data + offset;
+}
+
+void endUploadRegion(UploadRing &ring)
+{
+	ring.fences[ring.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
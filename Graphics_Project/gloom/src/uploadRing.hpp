@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <stdint.h>
+
+// Ring buffer for data that changes every frame (instance matrices, selection, picking IDs). The buffer is created
+// with glBufferStorage and stays persistently mapped with a coherent mapping, so data is written with a plain memcpy
+// and the driver never has to synchronize or copy it. The buffer is split into one region per frame in flight, and
+// a fence at the end of every frame guards its region until the GPU has read it. Requires OpenGL 4.4.
+
+// Frames in flight (regions of the ring)
+#define UPLOAD_RING_REGION_COUNT 3
+
+// Upload ring
+struct UploadRing
+{
+	GLuint buffer;
+	char *data; // Persistent mapping of the whole buffer
+	GLsizeiptr regionSize; // Bytes per region
+	GLsizeiptr alignment; // Alignment of the uploads (the shader storage buffer offset alignment)
+	unsigned int region; // Region of the current frame
+	GLsizeiptr offset; // Bytes used in the current region
+	GLsync fences[UPLOAD_RING_REGION_COUNT]; // Fence of every region the GPU may still read (0 if it's free)
+
+	// Statistics
+	uint64_t bytesUploaded;
+	uint64_t waits; // Frames that had to wait for the GPU to release their region
+};
+
+// Creates an upload ring of UPLOAD_RING_REGION_COUNT regions of 'regionSize' bytes
+UploadRing createUploadRing(const GLsizeiptr regionSize);
+
+// Unmaps and deletes the buffer, waiting for the GPU to finish with it
+void destroyUploadRing(UploadRing &ring);
+
+// Starts writing the region of the next frame, waiting for the GPU if it still reads from it
+void beginUploadRegion(UploadRing &ring);
+
+// Reserves 'size' bytes in the current region and returns a pointer to write them to. The offset of the data in
+// the buffer (for glBindBufferRange) is written to 'offset'. If the region is full, the ring grows into a new buffer
+// (which waits for the GPU), so bind the buffer after reserving.
+void *reserveUpload(UploadRing &ring, const GLsizeiptr size, GLintptr &offset);
+
+// Ends the region of the current frame, after the draws that read from it have been submitted
+void endUploadRegion(UploadRing &ring);
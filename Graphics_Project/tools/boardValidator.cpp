@@ -0,0 +1,224 @@
+// Validates board files in bulk and prints statistics for every board, e.g.
+//     boardValidator ../boards ../../Image_Processing_Project/solutions
+// Arguments can be board files or directories of board files. Files are memory mapped and parsed in parallel.
+// Returns 0 if every board is valid.
+
+#include "boardState.hpp"
+#include "jobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <dirent.h>
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+// Boards per job
+#define VALIDATOR_JOB_SIZE 16
+
+// Read-only memory mapping of a file
+struct MappedFile
+{
+	const char *data;
+	size_t size;
+#ifdef _WIN32
+	HANDLE file, mapping;
+#else
+	int file;
+#endif
+};
+
+// Maps 'filepath' into memory. Returns false if the file can't be opened.
+static bool mapFile(const std::string &filepath, MappedFile &mapped)
+{
+	mapped.data = 0;
+	mapped.size = 0;
+#ifdef _WIN32
+	mapped.mapping = 0;
+	mapped.file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if(mapped.file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(mapped.file, &size);
+	mapped.size = (size_t) size.QuadPart;
+	if(mapped.size == 0) return true; // Empty files can't be mapped
+
+	mapped.mapping = CreateFileMappingA(mapped.file, 0, PAGE_READONLY, 0, 0, 0);
+	if(mapped.mapping) mapped.data = (const char*) MapViewOfFile(mapped.mapping, FILE_MAP_READ, 0, 0, 0);
+	return mapped.data != 0;
+#else
+	mapped.file = open(filepath.c_str(), O_RDONLY);
+	if(mapped.file < 0) return false;
+
+	struct stat info;
+	if(fstat(mapped.file, &info) != 0 || !S_ISREG(info.st_mode)) return false;
+	mapped.size = (size_t) info.st_size;
+	if(mapped.size == 0) return true; // Empty files can't be mapped
+
+	void *data = mmap(0, mapped.size, PROT_READ, MAP_PRIVATE, mapped.file, 0);
+	if(data == MAP_FAILED) return false;
+	mapped.data = (const char*) data;
+	return true;
+#endif
+}
+
+static void unmapFile(MappedFile &mapped)
+{
+#ifdef _WIN32
+	if(mapped.data) UnmapViewOfFile(mapped.data);
+	if(mapped.mapping) CloseHandle(mapped.mapping);
+	if(mapped.file != INVALID_HANDLE_VALUE) CloseHandle(mapped.file);
+#else
+	if(mapped.data) munmap((void*) mapped.data, mapped.size);
+	if(mapped.file >= 0) close(mapped.file);
+#endif
+}
+
+// Appends the board files in 'path' to 'filepaths' (or 'path' itself if it isn't a directory)
+static void findBoardFiles(const std::string &path, std::vector<std::string> &filepaths)
+{
+	std::vector<std::string> names;
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((path + "\\*").c_str(), &data);
+	if(find == INVALID_HANDLE_VALUE || !(GetFileAttributesA(path.c_str()) & FILE_ATTRIBUTE_DIRECTORY))
+	{
+		if(find != INVALID_HANDLE_VALUE) FindClose(find);
+		filepaths.push_back(path);
+		return;
+	}
+	do
+	{
+		if(!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) names.push_back(data.cFileName);
+	}
+	while(FindNextFileA(find, &data));
+	FindClose(find);
+#else
+	DIR *directory = opendir(path.c_str());
+	if(!directory)
+	{
+		filepaths.push_back(path);
+		return;
+	}
+	while(dirent *entry = readdir(directory))
+	{
+		// Only regular files. stat() follows links, and answers when the file system doesn't fill in d_type.
+		if(entry->d_name[0] == '.') continue;
+		bool regularFile = entry->d_type == DT_REG;
+		if(entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN)
+		{
+			struct stat status;
+			regularFile = stat((path + "/" + entry->d_name).c_str(), &status) == 0 && S_ISREG(status.st_mode);
+		}
+		if(regularFile) names.push_back(entry->d_name);
+	}
+	closedir(directory);
+#endif
+
+	// Sort the names so that the output doesn't depend on the directory order
+	std::sort(names.begin(), names.end());
+	for(const std::string &name : names)
+	{
+		filepaths.push_back(path + "/" + name);
+	}
+}
+
+// Validation result and statistics of one board
+struct BoardReport
+{
+	bool valid;
+	std::string error;
+	BoardState state;
+};
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		printf("Usage: %s <board file or directory>...\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<std::string> filepaths;
+	for(int i = 1; i < argc; i++)
+	{
+		findBoardFiles(argv[i], filepaths);
+	}
+
+	// Map and parse every board in parallel, the board is parsed straight from the mapped pages
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	initJobSystem();
+	std::vector<BoardReport> reports(filepaths.size());
+	parallelFor(filepaths.size(), VALIDATOR_JOB_SIZE, [&](unsigned int begin, unsigned int end)
+	{
+		for(unsigned int i = begin; i < end; i++)
+		{
+			BoardReport &report = reports[i];
+			MappedFile mapped;
+			if(mapFile(filepaths[i], mapped))
+			{
+				report.valid = parseBoardState(mapped.data, mapped.size, report.state, &report.error);
+			}
+			else
+			{
+				report.valid = false;
+				report.error = "could not open file";
+			}
+			unmapFile(mapped);
+		}
+	});
+	const unsigned int threadCount = getJobThreadCount();
+	shutdownJobSystem();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	// Per-board statistics: start colour, empty ratio and shape histogram
+	static const char *shapeColumns[SHAPE_COUNT] = { "", "TRI", "PAR", "ARR", "HXW", "HXB", "STA", "CAK" };
+	printf("%-40s %-5s %6s", "Board", "Start", "Empty");
+	for(int shape = SHAPE_NONE + 1; shape < SHAPE_COUNT; shape++)
+	{
+		printf(" %4s", shapeColumns[shape]);
+	}
+	printf("\n");
+
+	unsigned int invalidCount = 0;
+	int totals[SHAPE_COUNT] = {};
+	for(unsigned int i = 0; i < reports.size(); i++)
+	{
+		const BoardReport &report = reports[i];
+		if(!report.valid)
+		{
+			printf("%-40s INVALID: %s\n", filepaths[i].c_str(), report.error.c_str());
+			invalidCount++;
+			continue;
+		}
+
+		printf("%-40s %-5s %5.1f%%", filepaths[i].c_str(), report.state.startWithBlue ? "BLUE" : "RED",
+			100.0f * countShapes(report.state, SHAPE_NONE) / BOARD_TILE_COUNT);
+		for(int shape = SHAPE_NONE; shape < SHAPE_COUNT; shape++)
+		{
+			const int count = countShapes(report.state, (Shape) shape);
+			totals[shape] += count;
+			if(shape != SHAPE_NONE) printf(" %4d", count);
+		}
+		printf("\n");
+	}
+
+	// Summary
+	const unsigned int validCount = reports.size() - invalidCount;
+	printf("\n%u boards, %u valid, %u invalid, in %.3f ms on %u threads\n", (unsigned int) reports.size(), validCount, invalidCount, seconds * 1000.0, threadCount);
+	if(validCount > 0)
+	{
+		printf("Average empty ratio %.1f%%\n", 100.0f * totals[SHAPE_NONE] / (validCount * BOARD_TILE_COUNT));
+	}
+
+	return invalidCount == 0 ? 0 : 2;
+}
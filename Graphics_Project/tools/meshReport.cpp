@@ -0,0 +1,42 @@
+// Prints the vertex cache optimization of the meshes of a board (the shapes and the board itself), e.g.
+//     meshReport ../boards/EASY_01
+// The ACMR (cache misses per triangle) before the reordering is measured after the duplicate vertices are welded, so
+// the two columns only differ by the reordering.
+
+#include "boardState.hpp"
+#include "boardScene.hpp"
+#include "mesh.hpp"
+
+#include <cstdio>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		printf("Usage: %s <board>\n", argv[0]);
+		return 1;
+	}
+
+	BoardState state;
+	std::string error;
+	if(!loadBoardState(argv[1], state, &error))
+	{
+		printf("Could not load board '%s': %s\n", argv[1], error.c_str());
+		return 1;
+	}
+
+	// Building the scene registers the meshes
+	BoardScene scene;
+	createBoardScene(state, scene);
+
+	printf("%6s %10s %18s %16s\n", "Mesh", "Triangles", "Vertices", "ACMR");
+	for(int meshID = 0; meshID < getMeshCount(); meshID++)
+	{
+		const Mesh &mesh = getMesh(meshID);
+		const MeshOptimizationStats &stats = mesh.optimizationStats;
+		printf("%6d %10u %8u -> %6u %7.3f -> %5.3f\n", meshID, (unsigned int) mesh.indices.size() / 3,
+			stats.vertexCountBefore, stats.vertexCountAfter, stats.acmrBefore, stats.acmrAfter);
+	}
+	return 0;
+}
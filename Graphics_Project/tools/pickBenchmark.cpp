@@ -0,0 +1,114 @@
+// Microbenchmark and correctness check for BVH ray picking: a board of 100k pieces picked with random rays
+
+#include "picking.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Returns a random float in [0, 1)
+static float randomFloat()
+{
+	return rand() / (RAND_MAX + 1.0f);
+}
+
+// Tests every item, for reference
+static int pickBruteForce(const std::vector<PickBounds> &bounds, const PickRay &ray, float *distance)
+{
+	float closest = FLT_MAX;
+	int closestItem = -1;
+	for(unsigned int i = 0; i < bounds.size(); i++)
+	{
+		BVH single;
+		buildBVH(single, std::vector<PickBounds>(1, bounds[i]));
+		float t;
+		if(pickBVH(single, ray, &t) == 0 && t < closest)
+		{
+			closest = t;
+			closestItem = i;
+		}
+	}
+	*distance = closest;
+	return closestItem;
+}
+
+int main(int argc, char *argv[])
+{
+	const unsigned int pieceCount = argc > 1 ? atoi(argv[1]) : 100000;
+	const unsigned int rayCount = 10000;
+	const unsigned int side = (unsigned int) ceil(sqrt((double) pieceCount));
+
+	// Pieces on a square board, like the shapes on the game board
+	std::vector<PickBounds> bounds(pieceCount);
+	for(unsigned int i = 0; i < pieceCount; i++)
+	{
+		const glm::vec3 center(i % side + 0.5f, i / side + 0.5f, 0.25f);
+		const glm::vec3 extents(0.375f, 0.375f, 0.25f * randomFloat() + 0.05f);
+		bounds[i].min = center - extents;
+		bounds[i].max = center + extents;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	BVH bvh;
+	buildBVH(bvh, bounds);
+	const double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Rays from a camera above the board towards random points on it
+	std::vector<PickRay> rays(rayCount);
+	for(PickRay &ray : rays)
+	{
+		ray.origin = glm::vec3(side * randomFloat(), side * randomFloat() - side * 0.25f, side * 0.5f);
+		const glm::vec3 target(side * randomFloat(), side * randomFloat(), 0.0f);
+		ray.direction = glm::normalize(target - ray.origin);
+	}
+
+	start = std::chrono::steady_clock::now();
+	unsigned int hits = 0;
+	for(const PickRay &ray : rays)
+	{
+		hits += pickBVH(bvh, ray) >= 0;
+	}
+	const double pickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Check a few rays against brute force
+	unsigned int mismatches = 0;
+	for(unsigned int r = 0; r < 20; r++)
+	{
+		float bvhDistance, bruteDistance;
+		const int bvhItem = pickBVH(bvh, rays[r], &bvhDistance);
+		const int bruteItem = pickBruteForce(bounds, rays[r], &bruteDistance);
+		if(bvhItem != bruteItem && bvhDistance != bruteDistance) mismatches++;
+	}
+
+	// Move pieces to random places on the board, like moves do, and check the refitted tree again
+	const unsigned int updateCount = 1000;
+	start = std::chrono::steady_clock::now();
+	for(unsigned int u = 0; u < updateCount; u++)
+	{
+		const unsigned int i = rand() % pieceCount;
+		const glm::vec3 offset(floorf(side * randomFloat()) - floorf(bounds[i].min.x), floorf(side * randomFloat()) - floorf(bounds[i].min.y), 0.0f);
+		bounds[i].min += offset;
+		bounds[i].max += offset;
+		updateBVHItem(bvh, i, bounds[i]);
+	}
+	const double updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	for(unsigned int r = 0; r < 20; r++)
+	{
+		float bvhDistance, bruteDistance;
+		const int bvhItem = pickBVH(bvh, rays[r], &bvhDistance);
+		const int bruteItem = pickBruteForce(bounds, rays[r], &bruteDistance);
+		if(bvhItem != bruteItem && bvhDistance != bruteDistance) mismatches++;
+	}
+
+	printf("%u pieces, %u BVH nodes, built in %.2f ms\n", pieceCount, (unsigned int) bvh.nodes.size(), buildMs);
+	printf("%u rays (%u hits) in %.2f ms, %.4f ms per pick\n", rayCount, hits, pickMs, pickMs / rayCount);
+	printf("%u piece moves in %.2f ms, %.4f ms per move\n", updateCount, updateMs, updateMs / updateCount);
+	printf("%u mismatches against brute force (before and after the moves)\n", mismatches);
+	return mismatches == 0 ? 0 : 1;
+}
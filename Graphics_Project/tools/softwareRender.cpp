@@ -0,0 +1,77 @@
+// Renders a board with the software rasterizer, without a GPU or a window, e.g.
+//     softwareRender ../boards/EASY_01 EASY_01.png [width] [height] [depth pfm]
+// The camera matches the start of the program. Useful on machines without OpenGL, and as a reference for the GL
+// path's geometry: the depth buffer (written if 'depth pfm' is given) matches GL, the colours don't, since the
+// material textures and the shadows aren't drawn (see softwareRasterizer.hpp).
+
+#include "boardState.hpp"
+#include "boardScene.hpp"
+#include "drawInstance.hpp"
+#include "jobSystem.hpp"
+#include "mesh.hpp"
+#include "softwareRasterizer.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+	if(argc < 3)
+	{
+		printf("Usage: %s <board> <output png> [width] [height] [depth pfm]\n", argv[0]);
+		return 1;
+	}
+	const int width = argc > 3 ? atoi(argv[3]) : 1024;
+	const int height = argc > 4 ? atoi(argv[4]) : 768;
+	if(width <= 0 || height <= 0)
+	{
+		printf("Invalid image size %d x %d\n", width, height);
+		return 1;
+	}
+
+	BoardState state;
+	std::string error;
+	if(!loadBoardState(argv[1], state, &error))
+	{
+		printf("Could not load board '%s': %s\n", argv[1], error.c_str());
+		return 1;
+	}
+
+	// Build the scene without a GL context (no render backend is set, so the meshes only live in the registry)
+	initJobSystem();
+	BoardScene scene;
+	createBoardScene(state, scene);
+
+	// Same camera as at the start of the program
+	const glm::mat4 projectionMatrix = glm::perspective(1.0f, (float) width / (float) height, 1.0f, 100.0f);
+	const glm::mat4 viewProjectionMatrix = getCameraViewProjectionMatrix(projectionMatrix, glm::vec3(0.0f, 4.0f, 7.0f), 20.0f, 90.0f);
+	std::vector<DrawInstance> instances;
+	collectDrawInstances(scene.boardNode, viewProjectionMatrix, instances);
+
+	// Draw
+	SoftwareFramebuffer framebuffer = createSoftwareFramebuffer(width, height);
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	clearSoftwareFramebuffer(framebuffer, glm::vec4(0.3f, 0.3f, 0.4f, 1.0f));
+	drawSoftwareInstances(framebuffer, instances.data(), instances.size());
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	printf("Drew %u instances at %d x %d in %.3f ms on %u threads\n", (unsigned int) instances.size(), width, height, seconds * 1000.0, getJobThreadCount());
+	shutdownJobSystem();
+
+	if(!saveSoftwareFramebuffer(framebuffer, argv[2]))
+	{
+		printf("Could not write '%s'\n", argv[2]);
+		return 1;
+	}
+	if(argc > 5 && !saveSoftwareDepth(framebuffer, argv[5]))
+	{
+		printf("Could not write '%s'\n", argv[5]);
+		return 1;
+	}
+	return 0;
+}
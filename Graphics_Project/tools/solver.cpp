@@ -0,0 +1,103 @@
+// Finds the shortest sequence of moves between two board files, e.g.
+//     solver ../boards/DIFFICULT_01 ../../Image_Processing_Project/solutions/DIFFICULT_01
+
+#include "boardState.hpp"
+#include "boardSolver.hpp"
+#include "jobSystem.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+
+// Returns the peak resident memory of the process in bytes
+static unsigned long long getPeakMemoryUsage()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	#ifdef __APPLE__
+		return usage.ru_maxrss; // Bytes on macOS
+	#else
+		return usage.ru_maxrss * 1024ull; // Kilobytes on Linux
+	#endif
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc < 3)
+	{
+		printf("Usage: %s <board> <target board> [threads] [table size bits]\n", argv[0]);
+		return 1;
+	}
+
+	// Load boards
+	BoardState start, target;
+	std::string error;
+	if(!loadBoardState(argv[1], start, &error))
+	{
+		printf("Could not load board '%s': %s\n", argv[1], error.c_str());
+		return 1;
+	}
+	if(!loadBoardState(argv[2], target, &error))
+	{
+		printf("Could not load board '%s': %s\n", argv[2], error.c_str());
+		return 1;
+	}
+
+	// Checked before the workers are started, so this exit doesn't have to shut them down
+	if(!haveSameShapes(start, target))
+	{
+		printf("No solution: the boards don't contain the same shapes\n");
+		return 2;
+	}
+
+	const unsigned int threadCount = argc > 3 ? atoi(argv[3]) : 0;
+	const unsigned int tableBits = argc > 4 ? atoi(argv[4]) : SOLVER_DEFAULT_TABLE_BITS;
+	initJobSystem(threadCount > 0 ? threadCount - 1 : 0);
+
+	printf("Solving with %u threads, at least %d moves needed\n", getJobThreadCount(), estimateMoveCount(start, target));
+
+	// Search
+	std::vector<TileMove> moves;
+	SolverStats stats;
+	const unsigned int maxMoves = 2 * BOARD_TILE_COUNT;
+	const bool solved = solveBoard(start, target, moves, &stats, maxMoves, tableBits);
+	shutdownJobSystem();
+
+	if(solved)
+	{
+		printf("Solved in %u moves:\n", (unsigned int) moves.size());
+		for(const TileMove &move : moves)
+		{
+			printf("    %s [%d, %d] -> [%d, %d]\n", getShapeName(getTileShape(start, move.fromX, move.fromY)), move.fromX, move.fromY, move.toX, move.toY);
+			moveTileShape(start, move.fromX, move.fromY, move.toX, move.toY);
+		}
+	}
+	else
+	{
+		printf("No solution within %u moves (the search gave up)\n", maxMoves);
+	}
+
+	// Statistics
+	printf("%llu nodes in %.3f s (%.0f nodes/s), %u iterations, %u subtrees\n",
+		(unsigned long long) stats.nodes, stats.seconds, stats.seconds > 0.0 ? stats.nodes / stats.seconds : 0.0, stats.iterations, stats.frontierSize);
+	printf("Transposition table %.1f MB, peak memory %.1f MB\n", stats.tableBytes / (1024.0 * 1024.0), getPeakMemoryUsage() / (1024.0 * 1024.0));
+
+	return solved ? 0 : 2;
+}
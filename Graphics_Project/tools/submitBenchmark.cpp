@@ -0,0 +1,133 @@
+// Measures the CPU cost of building and submitting frames, without a GPU: a grid of boards is collected into draw
+// instances and submitted to the null render backend every frame, e.g.
+//     submitBenchmark ../boards/EASY_01 [boards] [frames] [sort] [threads] [moving]
+// With sort 0 the draw list is submitted in scene order, to compare the state changes with the sorted list.
+// The draw lists are built on 'threads' threads (0 = all hardware threads), to measure how the build scales.
+// One shape on board 'moving' (-1 = none) is kept moving, to count the shadow cascades that have to be drawn again
+// while the rest are cached. Board 0 is nearest to the camera and lies in every cascade; boards further away lie in
+// fewer of them.
+
+#include "boardState.hpp"
+#include "boardScene.hpp"
+#include "drawInstance.hpp"
+#include "drawList.hpp"
+#include "jobSystem.hpp"
+#include "material.hpp"
+#include "mesh.hpp"
+#include "recordingRenderBackend.hpp"
+#include "shadowCascades.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		printf("Usage: %s <board> [boards] [frames] [sort] [threads] [moving]\n", argv[0]);
+		return 1;
+	}
+	const int boardCount = argc > 2 ? atoi(argv[2]) : 100;
+	const int frameCount = argc > 3 ? atoi(argv[3]) : 1000;
+	const bool sortCommands = argc > 4 ? atoi(argv[4]) != 0 : true;
+	const unsigned int threadCount = argc > 5 ? atoi(argv[5]) : 0;
+	const int movingBoard = argc > 6 ? atoi(argv[6]) : 0;
+
+	BoardState state;
+	std::string error;
+	if(!loadBoardState(argv[1], state, &error))
+	{
+		printf("Could not load board '%s': %s\n", argv[1], error.c_str());
+		return 1;
+	}
+
+	// Lay the boards out in a grid under one root node
+	initJobSystem(threadCount > 0 ? threadCount - 1 : 0);
+	RecordingRenderBackend *backend = createRecordingRenderBackend(false);
+	setMeshRenderBackend(backend);
+	setMaterialRenderBackend(backend);
+	SceneNode *root = createSceneNode();
+	SceneNode *movingShape = 0;
+	const int columns = (int) ceil(sqrt((double) boardCount));
+	for(int i = 0; i < boardCount; i++)
+	{
+		BoardScene scene;
+		createBoardScene(state, scene);
+		scene.boardNode->currentTransformationMatrix = glm::translate(glm::vec3((i % columns) * 10.0f, 0.0f, (i / columns) * -7.0f)) * scene.boardNode->currentTransformationMatrix;
+		addChild(root, scene.boardNode);
+		for(int tile = 0; tile < BOARD_TILE_COUNT && !movingShape && i == movingBoard; tile++)
+		{
+			movingShape = scene.tileNodes[tile / BOARD_WIDTH][tile % BOARD_WIDTH];
+		}
+	}
+	const glm::mat4 projectionMatrix = glm::perspective(1.0f, 4.0f / 3.0f, 1.0f, 100.0f);
+	const glm::mat4 viewProjectionMatrix = getCameraViewProjectionMatrix(projectionMatrix, glm::vec3(0.0f, 4.0f, 7.0f), 20.0f, 90.0f);
+	ShadowCascades shadows = createShadowCascades(glm::vec3(0.3f, -1.0f, -0.5f));
+	std::vector<DrawCommand> shadowCommands;
+	const float movingShapeX = movingShape ? movingShape->x : 0.0f;
+	TransformBuilder transforms;
+
+	// Build and submit frames
+	std::vector<DrawInstance> instances;
+	std::vector<DrawCommand> commands, scratch;
+	DrawListBuilder builder;
+	double buildSeconds = 0.0;
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for(int frame = 0; frame < frameCount; frame++)
+	{
+		// Move the shape back and forth across its tile
+		if(movingShape)
+		{
+			movingShape->x = movingShapeX + 0.25f * sinf(frame * 0.1f);
+			initTransformationMatrices(transforms, &movingShape, 1);
+		}
+
+		instances.clear();
+		collectDrawInstances(root, viewProjectionMatrix, instances);
+		clearDirtyFlags(root);
+		const std::chrono::steady_clock::time_point buildStartTime = std::chrono::steady_clock::now();
+		buildDrawLists(builder, instances.data(), instances.size(), commands, 0);
+		if(sortCommands) sortDrawList(commands, scratch);
+		const unsigned int shadowPasses = updateShadowCascades(shadows, glm::inverse(viewProjectionMatrix), 1.0f, 100.0f, instances.data(), instances.size());
+		if(shadowPasses)
+		{
+			buildShadowDrawList(instances.data(), instances.size(), shadowCommands);
+			sortDrawList(shadowCommands, scratch);
+		}
+		buildSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStartTime).count();
+
+		backend->updateInstances(instances.data(), instances.size());
+		backend->beginFrame(glm::vec4(0.3f, 0.3f, 0.4f, 1.0f));
+		for(int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+		{
+			if(shadowPasses & (1 << cascade)) backend->submitShadowPass(cascade, shadows.cascades[cascade].viewProjection, shadowCommands.data(), shadowCommands.size());
+		}
+		backend->setShadowCascades(shadows.cascades, glm::inverse(viewProjectionMatrix));
+		backend->submitDrawList(commands.data(), commands.size());
+		backend->endFrame();
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	printf("%d boards, %u instances per frame, %u visible\n", boardCount, (unsigned int) instances.size(), (unsigned int) commands.size());
+	printf("%.2f us per frame, %.1f ns per instance (%llu draws in %d frames)\n", seconds * 1e6 / frameCount,
+		seconds * 1e9 / ((double) frameCount * instances.size()), (unsigned long long) backend->commandCounts[RENDER_COMMAND_DRAW], frameCount);
+	printf("Shadow cascades: %.2f of %d drawn per frame (%.1f caster draws), %llu reused from the cache\n",
+		(double) backend->commandCounts[RENDER_COMMAND_SHADOW_PASS] / frameCount, SHADOW_CASCADE_COUNT,
+		(double) backend->commandCounts[RENDER_COMMAND_SHADOW_DRAW] / frameCount, (unsigned long long) shadows.cachedCascades);
+	printf("Draw list build (cull, key, merge, sort and shadow cascades) %.2f us per frame on %u threads\n", buildSeconds * 1e6 / frameCount, getJobThreadCount());
+	printf("%s draw list: %.1f mesh binds (instanced draws) per frame\n", sortCommands ? "Sorted" : "Unsorted",
+		(double) backend->commandCounts[RENDER_COMMAND_BIND_MESH] / frameCount);
+
+	setMeshRenderBackend(0);
+	setMaterialRenderBackend(0);
+	delete backend;
+	shutdownJobSystem();
+	return 0;
+}
@@ -0,0 +1,58 @@
+// Compresses textures offline into the texture cache, so the program finds them there on startup, and reports the
+// compression, e.g.
+//     textureCompressor textureCache bc1 ../gloom/textures/*.png
+// Formats: rgba8, bc1, bc3. The blocks of every texture are compressed in parallel.
+
+#include "jobSystem.hpp"
+#include "textureLoader.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+	if(argc < 4)
+	{
+		printf("Usage: %s <cache directory> <rgba8|bc1|bc3> <image>...\n", argv[0]);
+		return 1;
+	}
+
+	// Format
+	TextureFormat format = TEXTURE_FORMAT_COUNT;
+	static const char *formatNames[TEXTURE_FORMAT_COUNT] = { "rgba8", "bc1", "bc3" };
+	for(int i = 0; i < TEXTURE_FORMAT_COUNT; i++)
+	{
+		if(strcmp(argv[2], formatNames[i]) == 0) format = (TextureFormat) i;
+	}
+	if(format == TEXTURE_FORMAT_COUNT)
+	{
+		printf("Unknown format '%s'\n", argv[2]);
+		return 1;
+	}
+
+	initJobSystem();
+	const size_t uncompressedBytes = getTextureMipOffset(TEXTURE_FORMAT_RGBA8, TEXTURE_MIP_COUNT);
+	unsigned int failedCount = 0;
+	for(int i = 3; i < argc; i++)
+	{
+		const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		TextureLayer layer;
+		bool fromCache;
+		std::string error;
+		if(!loadTextureLayer(argv[i], argv[1], format, layer, &fromCache, &error))
+		{
+			printf("%-40s FAILED: %s\n", argv[i], error.c_str());
+			failedCount++;
+			continue;
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		printf("%-40s %s %.1f KB (%.1f:1) in %.2f ms%s\n", argv[i], getTextureFormatName(layer.format), layer.data.size() / 1024.0,
+			(double) uncompressedBytes / layer.data.size(), seconds * 1000.0, fromCache ? " (already cached)" : "");
+	}
+	printf("%u threads\n", getJobThreadCount());
+	shutdownJobSystem();
+
+	return failedCount == 0 ? 0 : 2;
+}
@@ -0,0 +1,99 @@
+// Microbenchmark comparing the batch TRS-to-matrix kernel against the glm path used by initTransformationMatrix()
+
+#include "transformKernel.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Builds the matrices the same way initTransformationMatrix() does
+static void buildTransformMatricesGLM(const TransformBatch &batch, const unsigned int count, glm::mat4 *matrices)
+{
+	for(unsigned int i = 0; i < count; i++)
+	{
+		glm::mat4 matrix;
+		matrix = glm::rotate(matrix, batch.rotationX[i], glm::vec3(1.0f, 0.0f, 0.0f));
+		matrix = glm::rotate(matrix, batch.rotationY[i], glm::vec3(0.0f, 1.0f, 0.0f));
+		matrix = glm::rotate(matrix, batch.rotationZ[i], glm::vec3(0.0f, 0.0f, 1.0f));
+		matrix = glm::translate(matrix, glm::vec3(batch.x[i], batch.y[i], batch.z[i]));
+		matrix = glm::scale(matrix, glm::vec3(batch.scale[i]));
+		matrices[i] = matrix;
+	}
+}
+
+// Runs 'function' 'repetitions' times and returns the best time in milliseconds
+template<typename Function>
+static double timeBest(const int repetitions, Function function)
+{
+	double best = 1e30;
+	for(int r = 0; r < repetitions; r++)
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		function();
+		const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+// Returns the largest absolute difference between two sets of matrices
+static float maxDifference(const std::vector<glm::mat4> &a, const std::vector<glm::mat4> &b)
+{
+	float difference = 0.0f;
+	for(unsigned int i = 0; i < a.size(); i++)
+	{
+		for(int c = 0; c < 4; c++)
+		{
+			for(int r = 0; r < 4; r++)
+			{
+				difference = std::max(difference, std::fabs(a[i][c][r] - b[i][c][r]));
+			}
+		}
+	}
+	return difference;
+}
+
+int main(int argc, char *argv[])
+{
+	const unsigned int count = argc > 1 ? atoi(argv[1]) : 100000;
+	const int repetitions = 20;
+
+	// Random rotations in [-2pi, 2pi], translations in [-10, 10] and scales in [0.1, 2]
+	TransformBatch batch;
+	resizeTransformBatch(batch, count);
+	srand(1);
+	for(unsigned int i = 0; i < count; i++)
+	{
+		batch.rotationX[i] = (rand() / (float) RAND_MAX * 2.0f - 1.0f) * 6.2831853f;
+		batch.rotationY[i] = (rand() / (float) RAND_MAX * 2.0f - 1.0f) * 6.2831853f;
+		batch.rotationZ[i] = (rand() / (float) RAND_MAX * 2.0f - 1.0f) * 6.2831853f;
+		batch.x[i] = (rand() / (float) RAND_MAX * 2.0f - 1.0f) * 10.0f;
+		batch.y[i] = (rand() / (float) RAND_MAX * 2.0f - 1.0f) * 10.0f;
+		batch.z[i] = (rand() / (float) RAND_MAX * 2.0f - 1.0f) * 10.0f;
+		batch.scale[i] = 0.1f + rand() / (float) RAND_MAX * 1.9f;
+	}
+
+	std::vector<glm::mat4> reference(count), scalar(count), batched(count);
+	const double glmTime = timeBest(repetitions, [&]() { buildTransformMatricesGLM(batch, count, reference.data()); });
+	const double scalarTime = timeBest(repetitions, [&]() { buildTransformMatricesScalar(batch, 0, count, scalar.data()); });
+	const double batchTime = timeBest(repetitions, [&]() { buildTransformMatrices(batch, 0, count, batched.data()); });
+
+#ifdef TRANSFORM_KERNEL_SSE
+	const char *kernelName = "SSE";
+#else
+	const char *kernelName = "scalar";
+#endif
+
+	printf("%u nodes, best of %i runs\n", count, repetitions);
+	printf("  glm::rotate/translate/scale: %8.3f ms (%8.0f nodes/ms)\n", glmTime, count / glmTime);
+	printf("  scalar kernel:               %8.3f ms (%8.0f nodes/ms), max error %g\n", scalarTime, count / scalarTime, maxDifference(reference, scalar));
+	printf("  batch kernel:                %8.3f ms (%8.0f nodes/ms), max error %g (%s)\n", batchTime, count / batchTime, maxDifference(reference, batched), kernelName);
+
+	return EXIT_SUCCESS;
+}